@@ -212,9 +212,11 @@ public:
         }
       }
 
-      // output the 10V and 5V envelope outputs on CO1 and CO3
-      cv_out(CO1, cv_current_);
-      cv_out(CO3, cv_current_ / 2.0);
+      // output the 10V and 5V envelope outputs on CO1 and CO3, converting to millivolts once and halving the rounded
+      // value (half away from zero) for CO3
+      const int16_t mv = lround(cv_current_ * 1000.0);
+      const int16_t out[4] = {mv, 0, int16_t((mv + (mv < 0 ? -1 : 1)) / 2), 0};
+      cv_out_multi(out, (1 << CO1) | (1 << CO3));
     }
     else if (gate_)
     {
@@ -232,7 +234,6 @@ public:
       last_selected_env_ = selected_env_;
       Display.fill_rect(53, 55, 7, 9, DUINO_SH1106::Inverse);
       Display.fill_rect(68, 55, 7, 9, DUINO_SH1106::Inverse);
-      Display.display(53, 74, 6, 7);
     }
 
     // display gate
@@ -247,12 +248,15 @@ public:
       {
         Display.fill_rect(60, 25, 7, 7, DUINO_SH1106::Black);
       }
-      Display.display(60, 66, 3, 3);
     }
+
+    // send any status changes to the display
+    Display.flush();
   }
 
   void gate_callback()
   {
+    // for a gate shorter than the debounce lockout, this is called again with the falling edge once it expires
     gate_ = gt_read_debounce(DUINO_Function::GT3);
     if (gate_)
     {
@@ -279,7 +283,7 @@ public:
       Display.fill_rect(widgets_adsr_[selected]->x() - 1, 51 - v_last, 9, 3, DUINO_SH1106::Black);
       Display.fill_rect(widgets_adsr_[selected]->x() - 1, 51 - widget_save_->params.vals.v[selected], 9, 3,
           DUINO_SH1106::White);
-      Display.display(widgets_adsr_[selected]->x() - 1, widgets_adsr_[selected]->x() + 7, 1, 6);
+      Display.flush();
 
       // update ADSR value
       uint8_t e = selected > 3 ? 1 : 0;
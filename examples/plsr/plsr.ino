@@ -48,6 +48,7 @@
 #include <du-ino_widgets.h>
 #include <du-ino_save.h>
 #include <du-ino_clock.h>
+#include <du-ino_events.h>
 #include <du-ino_utils.h>
 
 #define CLOCK_BPM_MAX 300
@@ -120,7 +121,7 @@ public:
 
     Clock.begin();
     Clock.attach_clock_callback(clock_callback);
-    Clock.attach_external_callback(external_callback);
+    Clock.attach_external_callback(external_callback, true);
 
     gt_attach_interrupt(GT3, clock_ext_isr, CHANGE);
     gt_attach_interrupt(GT4, reset_isr, RISING);
@@ -178,6 +179,17 @@ public:
 
   virtual void function_loop()
   {
+    Events.dispatch();
+
+    // display step (here rather than in the clock callback, which runs in the timer ISR)
+    const int8_t step = current_step_;
+    if (step != displayed_step_)
+    {
+      invert_step(displayed_step_);
+      displayed_step_ = step;
+      invert_step(displayed_step_);
+    }
+
     widget_loop();
   }
 
@@ -215,11 +227,6 @@ public:
 
       // output triggers
       gt_out_multi(jacks, true, true);
-
-      // display step
-      invert_step(displayed_step_);
-      displayed_step_ = current_step_;
-      invert_step(displayed_step_);
     }
   }
 
@@ -227,10 +234,9 @@ public:
   {
     widget_save_->params.vals.clock_bpm = 0;
     
-    Display.fill_rect(widget_clock_->x() + 1, widget_clock_->y() + 1, 17, 7,
-        widget_clock_->inverted() ? DUINO_SH1106::White : DUINO_SH1106::Black);
+    Display.fill_rect(widget_clock_->x() + 1, widget_clock_->y() + 1, 17, 7, DUINO_SH1106::Black);
     display_clock(widget_clock_->x() + 1, widget_clock_->y() + 1, widget_save_->params.vals.clock_bpm,
-        widget_clock_->inverted() ? DUINO_SH1106::Black : DUINO_SH1106::White);
+        DUINO_SH1106::White);
     widget_clock_->display();
   }
 
@@ -240,9 +246,9 @@ public:
     {
       widget_save_->mark_changed();
       widget_save_->display();
-      Display.fill_rect(widget_measures_->x() + 1, widget_measures_->y() + 1, 11, 7, DUINO_SH1106::White);
+      Display.fill_rect(widget_measures_->x() + 1, widget_measures_->y() + 1, 11, 7, DUINO_SH1106::Black);
       display_step_count(widget_measures_->x() + 1, widget_measures_->y() + 1, widget_save_->params.vals.step_count,
-          DUINO_SH1106::Black);
+          DUINO_SH1106::White);
       widget_measures_->display();
     }
   }
@@ -254,9 +260,9 @@ public:
       Clock.set_bpm(widget_save_->params.vals.clock_bpm);
       widget_save_->mark_changed();
       widget_save_->display();
-      Display.fill_rect(widget_clock_->x() + 1, widget_clock_->y() + 1, 17, 7, DUINO_SH1106::White);
+      Display.fill_rect(widget_clock_->x() + 1, widget_clock_->y() + 1, 17, 7, DUINO_SH1106::Black);
       display_clock(widget_clock_->x() + 1, widget_clock_->y() + 1, widget_save_->params.vals.clock_bpm,
-          DUINO_SH1106::Black);
+          DUINO_SH1106::White);
       widget_clock_->display();
     }
   }
@@ -268,8 +274,8 @@ public:
       Clock.set_swing(widget_save_->params.vals.swing);
       widget_save_->mark_changed();
       widget_save_->display();
-      Display.fill_rect(widget_swing_->x() + 1, widget_swing_->y() + 1, 11, 7, DUINO_SH1106::White);
-      display_swing(widget_swing_->x() + 1, widget_swing_->y() + 1, widget_save_->params.vals.swing, DUINO_SH1106::Black);
+      Display.fill_rect(widget_swing_->x() + 1, widget_swing_->y() + 1, 11, 7, DUINO_SH1106::Black);
+      display_swing(widget_swing_->x() + 1, widget_swing_->y() + 1, widget_save_->params.vals.swing, DUINO_SH1106::White);
       widget_swing_->display();
     }
   }
@@ -55,6 +55,48 @@ static const unsigned char icons[] PROGMEM =
   0x60, 0x63, 0x0f, 0x0f, 0x0f, 0x63, 0x60  // trigger mode on
 };
 
+// keyboard outlines, page-ordered (white keys 17x52, black keys 11x27)
+static const unsigned char key_left[] PROGMEM =
+{
+  0xff, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0xff, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0xff, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0xff, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0xff, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x1f, 0x10, 0x10, 0x10, 0x10, 0x10, 0xf0,
+  0xff, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff,
+  0xff, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff,
+  0x0f, 0x08, 0x08, 0x08, 0x08, 0x08, 0x08, 0x08, 0x08, 0x08, 0x08, 0x08, 0x08, 0x08, 0x08, 0x08, 0x0f
+};
+
+static const unsigned char key_center[] PROGMEM =
+{
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff, 0x01, 0x01, 0x01, 0xff, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff, 0x00, 0x00, 0x00, 0xff, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff, 0x00, 0x00, 0x00, 0xff, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0xf0, 0x10, 0x10, 0x10, 0x10, 0x10, 0x1f, 0x00, 0x00, 0x00, 0x1f, 0x10, 0x10, 0x10, 0x10, 0x10, 0xf0,
+  0xff, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff,
+  0xff, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff,
+  0x0f, 0x08, 0x08, 0x08, 0x08, 0x08, 0x08, 0x08, 0x08, 0x08, 0x08, 0x08, 0x08, 0x08, 0x08, 0x08, 0x0f
+};
+
+static const unsigned char key_right[] PROGMEM =
+{
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0xff,
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff,
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff,
+  0xf0, 0x10, 0x10, 0x10, 0x10, 0x10, 0x1f, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff,
+  0xff, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff,
+  0xff, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff,
+  0x0f, 0x08, 0x08, 0x08, 0x08, 0x08, 0x08, 0x08, 0x08, 0x08, 0x08, 0x08, 0x08, 0x08, 0x08, 0x08, 0x0f
+};
+
+static const unsigned char key_black[] PROGMEM =
+{
+  0xff, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0xff,
+  0xff, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff,
+  0xff, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff,
+  0x07, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x07
+};
+
 void trig_isr();
 
 void trigger_mode_scroll_callback(int delta);
@@ -113,23 +155,26 @@ public:
 
     gt_attach_interrupt(GT3, trig_isr, FALLING);
 
+    // 12-bit input, so the quantizer does not jitter between adjacent notes
+    cv_set_oversampling(CI1, 2, true);
+
     // draw top line
     Display.draw_du_logo_sm(0, 0, DUINO_SH1106::White);
     Display.draw_text(16, 0, "QNTZR", DUINO_SH1106::White);
 
     // draw kays
-    draw_left_key(1, 11);     // C
-    draw_black_key(13, 11);   // Db
-    draw_center_key(19, 11);  // D
-    draw_black_key(31, 11);   // Eb
-    draw_right_key(37, 11);   // E
-    draw_left_key(55, 11);    // F
-    draw_black_key(67, 11);   // Gb
-    draw_center_key(73, 11);  // G
-    draw_black_key(85, 11);   // Ab
-    draw_center_key(91, 11);  // A
-    draw_black_key(103, 11);  // Bb
-    draw_right_key(109, 11);  // B
+    Display.draw_sprite(1, 11, 17, 52, key_left, NULL, DUINO_SH1106::White);     // C
+    Display.draw_sprite(13, 11, 11, 27, key_black, NULL, DUINO_SH1106::White);   // Db
+    Display.draw_sprite(19, 11, 17, 52, key_center, NULL, DUINO_SH1106::White);  // D
+    Display.draw_sprite(31, 11, 11, 27, key_black, NULL, DUINO_SH1106::White);   // Eb
+    Display.draw_sprite(37, 11, 17, 52, key_right, NULL, DUINO_SH1106::White);   // E
+    Display.draw_sprite(55, 11, 17, 52, key_left, NULL, DUINO_SH1106::White);    // F
+    Display.draw_sprite(67, 11, 11, 27, key_black, NULL, DUINO_SH1106::White);   // Gb
+    Display.draw_sprite(73, 11, 17, 52, key_center, NULL, DUINO_SH1106::White);  // G
+    Display.draw_sprite(85, 11, 11, 27, key_black, NULL, DUINO_SH1106::White);   // Ab
+    Display.draw_sprite(91, 11, 17, 52, key_center, NULL, DUINO_SH1106::White);  // A
+    Display.draw_sprite(103, 11, 11, 27, key_black, NULL, DUINO_SH1106::White);  // Bb
+    Display.draw_sprite(109, 11, 17, 52, key_right, NULL, DUINO_SH1106::White);  // B
 
     invert_note(current_displayed_note_);
     widget_setup(container_outer_);
@@ -146,17 +191,17 @@ public:
     {
       if (scale_ == 0)
       {
-        cv_out(CO1, 0.0);
+        cv_out_mv(CO1, 0);
         output_octave_ = 0;
         output_note_ = 0;
       }
       else
       {
         // read input
-        float input = cv_read(CI1);
+        const int16_t input = cv_read_mv(CI1);
 
         // find a lower bound
-        int below_octave = (int)input - 1;
+        int below_octave = input / 1000 - 1;
         uint8_t below_note = 0;
         while (!(scale_ & (1 << below_note)))
         {
@@ -166,7 +211,7 @@ public:
         // find closest lower and upper values
         int above_octave = below_octave, octave = below_octave;
         uint8_t above_note = below_note, note = below_note;
-        while (note_cv(above_octave, key_, above_note) < input)
+        while (note_mv(above_octave, key_, above_note) < input)
         {
           note++;
           if (note > 11)
@@ -185,17 +230,17 @@ public:
         }
 
         // output the nearer of the two values
-        float below = note_cv(below_octave, key_, below_note);
-        float above = note_cv(above_octave, key_, above_note);
+        const int16_t below = note_mv(below_octave, key_, below_note);
+        const int16_t above = note_mv(above_octave, key_, above_note);
         if (input - below < above - input)
         {
-          cv_out(CO1, below);
+          cv_out_mv(CO1, below);
           octave = below_octave;
           note = below_note;
         }
         else
         {
-          cv_out(CO1, above);
+          cv_out_mv(CO1, above);
           octave = above_octave;
           note = above_note;
         }
@@ -272,64 +317,22 @@ public:
   }
 
 private:
-  float note_cv(int octave, uint8_t key_, uint8_t note)
+  int16_t note_mv(int octave, uint8_t key_, uint8_t note)
   {
-    return (float)octave + (float)key_ / 12.0 + (float)note / 12.0;
-  }
-
-  void draw_left_key(int16_t x, int16_t y)
-  {
-    Display.draw_vline(x, y, 52, DUINO_SH1106::White);
-    Display.draw_hline(x + 1, y, 9, DUINO_SH1106::White);
-    Display.draw_hline(x + 1, y + 51, 15, DUINO_SH1106::White);
-    Display.draw_vline(x + 10, y, 29, DUINO_SH1106::White);
-    Display.draw_hline(x + 11, y + 28, 5, DUINO_SH1106::White);
-    Display.draw_vline(x + 16, y + 28, 24, DUINO_SH1106::White);
-  }
-
-  void draw_center_key(int16_t x, int16_t y)
-  {
-    Display.draw_vline(x, y + 28, 24, DUINO_SH1106::White);
-    Display.draw_hline(x + 1, y + 28, 5, DUINO_SH1106::White);
-    Display.draw_hline(x + 1, y + 51, 15, DUINO_SH1106::White);
-    Display.draw_vline(x + 6, y, 29, DUINO_SH1106::White);
-    Display.draw_hline(x + 7, y, 3, DUINO_SH1106::White);
-    Display.draw_vline(x + 10, y, 29, DUINO_SH1106::White);
-    Display.draw_hline(x + 11, y + 28, 5, DUINO_SH1106::White);
-    Display.draw_vline(x + 16, y + 28, 24, DUINO_SH1106::White);
-  }
-
-  void draw_right_key(int16_t x, int16_t y)
-  {
-    Display.draw_vline(x, y + 28, 24, DUINO_SH1106::White);
-    Display.draw_hline(x + 1, y + 28, 5, DUINO_SH1106::White);
-    Display.draw_hline(x + 1, y + 51, 15, DUINO_SH1106::White);
-    Display.draw_vline(x + 6, y, 29, DUINO_SH1106::White);
-    Display.draw_hline(x + 7, y, 9, DUINO_SH1106::White);
-    Display.draw_vline(x + 16, y, 52, DUINO_SH1106::White);
-  }
-
-  void draw_black_key(int16_t x, int16_t y)
-  {
-    Display.draw_vline(x, y, 27, DUINO_SH1106::White);
-    Display.draw_hline(x + 1, y, 9, DUINO_SH1106::White);
-    Display.draw_hline(x + 1, y + 26, 9, DUINO_SH1106::White);
-    Display.draw_vline(x + 10, y, 27, DUINO_SH1106::White);
+    return octave * 1000 + ((key_ + note) * 1000 + 6) / 12;
   }
 
   void display_trigger_mode()
   {
-    Display.fill_rect(widget_trigger_mode_->x() + 1, widget_trigger_mode_->y() + 1, 7, 7,
-        widget_trigger_mode_->inverted() ? DUINO_SH1106::White : DUINO_SH1106::Black);
+    Display.fill_rect(widget_trigger_mode_->x() + 1, widget_trigger_mode_->y() + 1, 7, 7, DUINO_SH1106::Black);
     Display.draw_bitmap_7(widget_trigger_mode_->x() + 1, widget_trigger_mode_->y() + 1, icons, trigger_mode_,
-        widget_trigger_mode_->inverted() ? DUINO_SH1106::Black : DUINO_SH1106::White);
+        DUINO_SH1106::White);
     widget_trigger_mode_->display();
   }
 
   void display_key()
   {
-    Display.fill_rect(widget_key_->x() + 1, widget_key_->y() + 1, 11, 7,
-        widget_key_->inverted() ? DUINO_SH1106::White : DUINO_SH1106::Black);
+    Display.fill_rect(widget_key_->x() + 1, widget_key_->y() + 1, 11, 7, DUINO_SH1106::Black);
 
     bool sharp = false;
     unsigned char letter;
@@ -368,12 +371,10 @@ private:
         break;
     }
 
-    Display.draw_char(widget_key_->x() + 1, widget_key_->y() + 1, letter,
-        widget_key_->inverted() ? DUINO_SH1106::Black : DUINO_SH1106::White);
+    Display.draw_char(widget_key_->x() + 1, widget_key_->y() + 1, letter, DUINO_SH1106::White);
     if (sharp)
     {
-      Display.draw_char(widget_key_->x() + 7, widget_key_->y() + 1, '#',
-          widget_key_->inverted() ? DUINO_SH1106::Black : DUINO_SH1106::White);
+      Display.draw_char(widget_key_->x() + 7, widget_key_->y() + 1, '#', DUINO_SH1106::White);
     }
 
     widget_key_->display();
@@ -381,15 +382,13 @@ private:
 
   void display_scale()
   {
-    Display.fill_rect(widget_scale_->x() + 1, widget_scale_->y() + 1, 17, 7,
-        widget_scale_->inverted() ? DUINO_SH1106::White : DUINO_SH1106::Black);
+    Display.fill_rect(widget_scale_->x() + 1, widget_scale_->y() + 1, 17, 7, DUINO_SH1106::Black);
     if (scale_id_ > -1)
     {
       for (uint8_t i = 0; i < 3; ++i)
       {
         Display.draw_char(widget_scale_->x() + 1 + i * 6, widget_scale_->y() + 1,
-            pgm_read_byte(&scales[scale_id_ * 5 + 2 + i]),
-            widget_scale_->inverted() ? DUINO_SH1106::Black : DUINO_SH1106::White);
+            pgm_read_byte(&scales[scale_id_ * 5 + 2 + i]), DUINO_SH1106::White);
       }
     }
 
@@ -404,18 +403,16 @@ private:
           white ? DUINO_SH1106::White : DUINO_SH1106::Black);
     }
 
-    Display.display();
+    Display.flush();
   }
 
   void invert_note(uint8_t note)
   {
-    bool refresh_lower = false;
     switch (note)
     {
       case 0:
         Display.fill_rect(2, 12, 9, 50, DUINO_SH1106::Inverse);
         Display.fill_rect(11, 40, 6, 22, DUINO_SH1106::Inverse);
-        refresh_lower = true;
         break;
       case 1:
         Display.fill_rect(14, 12, 9, 25, DUINO_SH1106::Inverse);
@@ -423,7 +420,6 @@ private:
       case 2:
         Display.fill_rect(26, 12, 3, 28, DUINO_SH1106::Inverse);
         Display.fill_rect(20, 40, 15, 22, DUINO_SH1106::Inverse);
-        refresh_lower = true;
         break;
       case 3:
         Display.fill_rect(32, 12, 9, 25, DUINO_SH1106::Inverse);
@@ -431,12 +427,10 @@ private:
       case 4:
         Display.fill_rect(44, 12, 9, 50, DUINO_SH1106::Inverse);
         Display.fill_rect(38, 40, 6, 22, DUINO_SH1106::Inverse);
-        refresh_lower = true;
         break;
       case 5:
         Display.fill_rect(56, 12, 9, 50, DUINO_SH1106::Inverse);
         Display.fill_rect(65, 40, 6, 22, DUINO_SH1106::Inverse);
-        refresh_lower = true;
         break;
       case 6:
         Display.fill_rect(68, 12, 9, 25, DUINO_SH1106::Inverse);
@@ -444,7 +438,6 @@ private:
       case 7:
         Display.fill_rect(80, 12, 3, 28, DUINO_SH1106::Inverse);
         Display.fill_rect(74, 40, 15, 22, DUINO_SH1106::Inverse);
-        refresh_lower = true;
         break;
       case 8:
         Display.fill_rect(86, 12, 9, 25, DUINO_SH1106::Inverse);
@@ -452,7 +445,6 @@ private:
       case 9:
         Display.fill_rect(98, 12, 3, 28, DUINO_SH1106::Inverse);
         Display.fill_rect(92, 40, 15, 22, DUINO_SH1106::Inverse);
-        refresh_lower = true;
         break;
       case 10:
         Display.fill_rect(104, 12, 9, 25, DUINO_SH1106::Inverse);
@@ -460,11 +452,10 @@ private:
       case 11:
         Display.fill_rect(116, 12, 9, 50, DUINO_SH1106::Inverse);
         Display.fill_rect(110, 40, 6, 22, DUINO_SH1106::Inverse);
-        refresh_lower = true;
         break;
     }
 
-    Display.display(2, 124, 1, refresh_lower ? 7 : 4);
+    Display.flush();
   }
 
   DUINO_WidgetContainer<2> * container_outer_;
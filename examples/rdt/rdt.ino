@@ -64,6 +64,17 @@ static const unsigned char loop_icons[] PROGMEM =
   0x84, 0x84, 0x84, 0x84, 0x84, 0x84, 0x48, 0x30   // right part
 };
 
+// 23x23 ring, page-ordered
+static const unsigned char circle[] PROGMEM =
+{
+  0x00, 0xc0, 0x20, 0x18, 0x08, 0x04, 0x02, 0x02, 0x01, 0x01, 0x01, 0x01,
+  0x01, 0x01, 0x01, 0x02, 0x02, 0x04, 0x08, 0x18, 0x20, 0xc0, 0x00,
+  0x7f, 0x80, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x80, 0x7f,
+  0x00, 0x01, 0x02, 0x0c, 0x08, 0x10, 0x20, 0x20, 0x40, 0x40, 0x40, 0x40,
+  0x40, 0x40, 0x40, 0x20, 0x20, 0x10, 0x08, 0x0c, 0x02, 0x01, 0x00
+};
+
 void clock_ext_isr();
 
 void clock_callback();
@@ -128,24 +139,9 @@ public:
     Display.fill_rect(widget_save_->x() + 1, widget_save_->y() + 1, 5, 5, DUINO_SH1106::White);
 
     // draw big circles
-    // FIXME: have to do this manually because draw_circle doesn't quite get it right
     for (uint8_t i = 0; i < 2; ++i)
     {
-      for (uint8_t j = 0; j < 2; ++j)
-      {
-        Display.draw_vline(j * 22 + i * 105, 22, 7, DUINO_SH1106::White);
-        Display.draw_hline(8 + i * 105, 14 + j * 22, 7, DUINO_SH1106::White);
-        for (uint8_t k = 0; k < 2; ++k)
-        {
-          Display.draw_vline(1 + k * 20 + i * 105, 20 + j * 9, 2, DUINO_SH1106::White);
-          Display.draw_hline(6 + k * 9 + i * 105, 15 + j * 20, 2, DUINO_SH1106::White);
-          Display.draw_pixel(2 + k * 18 + i * 105, 19 + j * 12, DUINO_SH1106::White);
-          Display.draw_pixel(3 + k * 16 + i * 105, 18 + j * 14, DUINO_SH1106::White);
-          Display.draw_pixel(3 + k * 16 + i * 105, 17 + j * 16, DUINO_SH1106::White);
-          Display.draw_pixel(4 + k * 14 + i * 105, 17 + j * 16, DUINO_SH1106::White);
-          Display.draw_pixel(5 + k * 12 + i * 105, 16 + j * 18, DUINO_SH1106::White);
-        }
-      }
+      Display.draw_sprite(i * 105, 14, 23, 23, circle, NULL, DUINO_SH1106::White);
     }
 
     // draw 1s down arrows
@@ -370,10 +366,9 @@ public:
   {
     widget_save_->params.vals.clock_bpm = 0;
     
-    Display.fill_rect(widget_clock_->x() + 1, widget_clock_->y() + 1, 17, 7,
-        widget_clock_->inverted() ? DUINO_SH1106::White : DUINO_SH1106::Black);
+    Display.fill_rect(widget_clock_->x() + 1, widget_clock_->y() + 1, 17, 7, DUINO_SH1106::Black);
     display_clock(widget_clock_->x() + 1, widget_clock_->y() + 1, widget_save_->params.vals.clock_bpm,
-        widget_clock_->inverted() ? DUINO_SH1106::Black : DUINO_SH1106::White);
+        DUINO_SH1106::White);
     widget_clock_->display();
   }
 
@@ -384,9 +379,9 @@ public:
       Clock.set_bpm(widget_save_->params.vals.clock_bpm);
       widget_save_->mark_changed();
       widget_save_->display();
-      Display.fill_rect(widget_clock_->x() + 1, widget_clock_->y() + 1, 17, 7, DUINO_SH1106::White);
+      Display.fill_rect(widget_clock_->x() + 1, widget_clock_->y() + 1, 17, 7, DUINO_SH1106::Black);
       display_clock(widget_clock_->x() + 1, widget_clock_->y() + 1, widget_save_->params.vals.clock_bpm,
-          DUINO_SH1106::Black);
+          DUINO_SH1106::White);
       widget_clock_->display();
     }
   }
@@ -398,8 +393,8 @@ public:
       Clock.set_swing(widget_save_->params.vals.swing);
       widget_save_->mark_changed();
       widget_save_->display();
-      Display.fill_rect(widget_swing_->x() + 1, widget_swing_->y() + 1, 11, 7, DUINO_SH1106::White);
-      display_swing(widget_swing_->x() + 1, widget_swing_->y() + 1, widget_save_->params.vals.swing, DUINO_SH1106::Black);
+      Display.fill_rect(widget_swing_->x() + 1, widget_swing_->y() + 1, 11, 7, DUINO_SH1106::Black);
+      display_swing(widget_swing_->x() + 1, widget_swing_->y() + 1, widget_save_->params.vals.swing, DUINO_SH1106::White);
       widget_swing_->display();
     }
   }
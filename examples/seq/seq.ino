@@ -214,6 +214,8 @@ public:
     }
     slew_filter_->set_frequency(slew_hz(widget_save_->params.vals.slew_rate));
 
+    set_address_oversampling();
+
     if (widget_save_->params.vals.clock_bpm < 0 || widget_save_->params.vals.clock_bpm > CLOCK_BPM_MAX)
     {
       widget_save_->params.vals.clock_bpm = 0;
@@ -302,8 +304,12 @@ public:
       // drop clock each step
       gt_out(GT2, false);
 
-      // update step clock time
+      // update step clock time, and gate time from the tracked external clock period
       clock_time_ = millis();
+      if (Clock.get_external())
+      {
+        gate_ms_ = widget_save_->params.vals.gate_time * (uint16_t)(Clock.get_period() / GATE_TIME_DIV);
+      }
     }
 
     // set gate state
@@ -340,9 +346,16 @@ public:
     }
 
     // set pitch CV state
-    const float pitch_cv = note_to_cv(widget_save_->params.vals.stage_pitch[cached_stage]);
+    const int8_t pitch = widget_save_->params.vals.stage_pitch[cached_stage];
     const bool slew_on = (bool)((widget_save_->params.vals.stage_slew >> cached_stage) & 1);
-    cv_out(CO1, slew_on ? slew_filter_->filter(pitch_cv) : pitch_cv);
+    if (slew_on)
+    {
+      cv_out(CO1, slew_filter_->filter(note_to_cv(pitch)));
+    }
+    else
+    {
+      cv_out_mv(CO1, note_to_mv(pitch));
+    }
 
     // set gate and clock states
     gt_out(GT1, gate_);
@@ -367,7 +380,6 @@ public:
       display_reverse_address(30, 12);
       last_diradd_mode_ = widget_save_->params.vals.diradd_mode;
       last_reverse_ = reverse_;
-      Display.display(30, 34, 1, 2);
     }
 
     // display half clock
@@ -376,7 +388,6 @@ public:
     {
       display_half_clock(41, 12, half_clock);
       last_half_clock_ = half_clock;
-      Display.display(41, 51, 1, 2);
     }
 
     // display gate
@@ -398,10 +409,10 @@ public:
       {
         display_gate(last_stage_cached, DUINO_SH1106::Black);
       }
-
-      Display.display(16 * last_stage_cached + 6, 16 * last_stage_cached + 9, 3, 3);
-      Display.display(16 * stage_ + 6, 16 * stage_ + 9, 3, 3);
     }
+
+    // send any status changes to the display
+    Display.flush();
   }
 
   void clock_ext_callback()
@@ -434,10 +445,9 @@ public:
   {
     widget_save_->params.vals.clock_bpm = 0;
     
-    Display.fill_rect(widget_clock_->x() + 1, widget_clock_->y() + 1, 17, 7,
-        widget_clock_->inverted() ? DUINO_SH1106::White : DUINO_SH1106::Black);
+    Display.fill_rect(widget_clock_->x() + 1, widget_clock_->y() + 1, 17, 7, DUINO_SH1106::Black);
     display_clock(widget_clock_->x() + 1, widget_clock_->y() + 1, widget_save_->params.vals.clock_bpm,
-        widget_clock_->inverted() ? DUINO_SH1106::Black : DUINO_SH1106::White);
+        DUINO_SH1106::White);
     widget_clock_->display();
   }
 
@@ -447,9 +457,9 @@ public:
     {
       widget_save_->mark_changed();
       widget_save_->display();
-      Display.fill_rect(widget_count_->x() + 1, widget_count_->y() + 1, 5, 7, DUINO_SH1106::White);
+      Display.fill_rect(widget_count_->x() + 1, widget_count_->y() + 1, 5, 7, DUINO_SH1106::Black);
       Display.draw_char(widget_count_->x() + 1, widget_count_->y() + 1, '0' + widget_save_->params.vals.stage_count,
-          DUINO_SH1106::Black);
+          DUINO_SH1106::White);
       widget_count_->display();
     }
   }
@@ -457,11 +467,12 @@ public:
   void widget_diradd_scroll_callback(int delta)
   {
     widget_save_->params.vals.diradd_mode = delta < 0 ? 0 : 1;
+    set_address_oversampling();
     widget_save_->mark_changed();
     widget_save_->display();
-    Display.fill_rect(widget_diradd_->x() + 1, widget_diradd_->y() + 1, 5, 7, DUINO_SH1106::White);
+    Display.fill_rect(widget_diradd_->x() + 1, widget_diradd_->y() + 1, 5, 7, DUINO_SH1106::Black);
     Display.draw_char(widget_diradd_->x() + 1, widget_diradd_->y() + 1,
-        widget_save_->params.vals.diradd_mode ? 'A' : 'D', DUINO_SH1106::Black);
+        widget_save_->params.vals.diradd_mode ? 'A' : 'D', DUINO_SH1106::White);
     widget_diradd_->display();
   }
 
@@ -472,9 +483,9 @@ public:
       slew_filter_->set_frequency(slew_hz(widget_save_->params.vals.slew_rate));
       widget_save_->mark_changed();
       widget_save_->display();
-      Display.fill_rect(widget_slew_->x() + 2, widget_slew_->y() + 2, 16, 5, DUINO_SH1106::White);
+      Display.fill_rect(widget_slew_->x() + 2, widget_slew_->y() + 2, 16, 5, DUINO_SH1106::Black);
       display_slew_rate(widget_slew_->x() + 2, widget_slew_->y() + 2, widget_save_->params.vals.slew_rate,
-          DUINO_SH1106::Black);
+          DUINO_SH1106::White);
       widget_slew_->display();
     }
   }
@@ -486,9 +497,9 @@ public:
       gate_ms_ = widget_save_->params.vals.gate_time * (uint16_t)(Clock.get_period() / GATE_TIME_DIV);
       widget_save_->mark_changed();
       widget_save_->display();
-      Display.fill_rect(widget_gate_->x() + 2, widget_gate_->y() + 2, 16, 5, DUINO_SH1106::White);
+      Display.fill_rect(widget_gate_->x() + 2, widget_gate_->y() + 2, 16, 5, DUINO_SH1106::Black);
       display_gate_time(widget_gate_->x() + 2, widget_gate_->y() + 2, widget_save_->params.vals.gate_time,
-          DUINO_SH1106::Black);
+          DUINO_SH1106::White);
       widget_gate_->display();
     }
   }
@@ -508,9 +519,9 @@ public:
       gate_ms_ = widget_save_->params.vals.gate_time * (uint16_t)(Clock.get_period() / GATE_TIME_DIV);
       widget_save_->mark_changed();
       widget_save_->display();
-      Display.fill_rect(widget_clock_->x() + 1, widget_clock_->y() + 1, 17, 7, DUINO_SH1106::White);
+      Display.fill_rect(widget_clock_->x() + 1, widget_clock_->y() + 1, 17, 7, DUINO_SH1106::Black);
       display_clock(widget_clock_->x() + 1, widget_clock_->y() + 1, widget_save_->params.vals.clock_bpm,
-          DUINO_SH1106::Black);
+          DUINO_SH1106::White);
       widget_clock_->display();
     }
   }
@@ -522,9 +533,9 @@ public:
       widget_save_->mark_changed();
       widget_save_->display();
       Display.fill_rect(widgets_pitch_->x(stage_selected), widgets_pitch_->y(stage_selected), 16, 15,
-          DUINO_SH1106::White);
+          DUINO_SH1106::Black);
       display_note(widgets_pitch_->x(stage_selected), widgets_pitch_->y(stage_selected),
-          widget_save_->params.vals.stage_pitch[stage_selected], DUINO_SH1106::Black);
+          widget_save_->params.vals.stage_pitch[stage_selected], DUINO_SH1106::White);
       widgets_pitch_->display();
     }
   }
@@ -536,9 +547,9 @@ public:
       widget_save_->mark_changed();
       widget_save_->display();
       Display.fill_rect(widgets_steps_->x(stage_selected) + 1, widgets_steps_->y(stage_selected) + 1, 5, 7,
-          DUINO_SH1106::White);
+          DUINO_SH1106::Black);
       Display.draw_char(widgets_steps_->x(stage_selected) + 1, widgets_steps_->y(stage_selected) + 1,
-          '0' + widget_save_->params.vals.stage_steps[stage_selected], DUINO_SH1106::Black);
+          '0' + widget_save_->params.vals.stage_steps[stage_selected], DUINO_SH1106::White);
       widgets_steps_->display();
     }
   }
@@ -550,9 +561,9 @@ public:
       widget_save_->mark_changed();
       widget_save_->display();
       Display.fill_rect(widgets_gate_->x(stage_selected) + 1, widgets_gate_->y(stage_selected) + 1, 7, 7,
-          DUINO_SH1106::White);
+          DUINO_SH1106::Black);
       Display.draw_bitmap_7(widgets_gate_->x(stage_selected) + 1, widgets_gate_->y(stage_selected) + 1,
-          gate_mode_icons, (GateMode)(widget_save_->params.vals.stage_gate[stage_selected]), DUINO_SH1106::Black);
+          gate_mode_icons, (GateMode)(widget_save_->params.vals.stage_gate[stage_selected]), DUINO_SH1106::White);
       widgets_gate_->display();
     }
   }
@@ -570,10 +581,10 @@ public:
     widget_save_->mark_changed();
     widget_save_->display();
     Display.fill_rect(widgets_slew_->x(stage_selected) + 1, widgets_slew_->y(stage_selected) + 1, 14, 4,
-        DUINO_SH1106::Black);
+        DUINO_SH1106::White);
     Display.fill_rect(widgets_slew_->x(stage_selected) + 2 + 6 *
         (~(widget_save_->params.vals.stage_slew >> stage_selected) & 1),
-        widgets_slew_->y(stage_selected) + 2, 6, 2, DUINO_SH1106::White);
+        widgets_slew_->y(stage_selected) + 2, 6, 2, DUINO_SH1106::Black);
     widgets_slew_->display();
   }
 
@@ -607,14 +618,22 @@ public:
 
   uint8_t address_to_stage()
   {
-    int8_t addr_stage = (int8_t)(cv_read(CI1) * 1.6);
+    // 1.6 stages per volt
+    int8_t addr_stage = (int8_t)(cv_read_mv(CI1) / 625);
     return (uint8_t)clamp<int8_t>(addr_stage, 0, widget_save_->params.vals.stage_count - 1);
   }
 
 private:
+  void set_address_oversampling()
+  {
+    // a steadier address is worth the latency (about 7 ms), but a reverse gate should respond immediately
+    cv_set_oversampling(CI1, widget_save_->params.vals.diradd_mode ? 2 : 0, widget_save_->params.vals.diradd_mode);
+  }
+
   bool partial_gate()
   {
-    return (Clock.get_external() && cached_clock_gate_)
+    // follow the external clock gate until its period is known
+    return (Clock.get_external() && !Clock.get_period() && cached_clock_gate_)
            || cached_retrigger_
            || ((millis() - clock_time_) < gate_ms_);
   }
@@ -624,6 +643,13 @@ private:
     return ((float)note - 36.0) / 12.0;
   }
 
+  int16_t note_to_mv(int8_t note)
+  {
+    // 1000 / 12 = 250 / 3 mV per semitone, rounded to the nearest millivolt
+    const int16_t n = ((int16_t)note - 36) * 250;
+    return (n < 0 ? n - 1 : n + 1) / 3;
+  }
+
   float slew_hz(uint8_t slew_rate)
   {
     if (slew_rate)
@@ -95,17 +95,17 @@ public:
     : p_(p)
     , x_(parameter ? 89 : 64)
     , w_(parameter ? 29 : 11)
-    , inverted_(false) { }
+    , overlay_(-1) { }
 
   virtual void invert(bool update_display = true)
   {
     // invert underline
-    Display.draw_hline(x_, 8, w_, DUINO_SH1106::Inverse);
+    overlay_ = toggle_overlay(overlay_, x_, 8, w_, 1, Full);
 
     // blank area
     Display.fill_rect(45, 0, 73, 7, DUINO_SH1106::Black);
 
-    if (!inverted_)
+    if (overlay_ != -1)
     {
       // display point number
       Display.draw_char(45, 0, '0' + p_, DUINO_SH1106::White);
@@ -116,15 +116,13 @@ public:
       }
     }
 
-    inverted_ = !inverted_;
-
     if (update_display)
     {
       Display.display(45, 117, 0, 1);
     }
   }
 
-  virtual bool inverted() const { return inverted_; }
+  virtual bool inverted() const { return overlay_ != -1; }
 
   void attach_invert_callback(void (*callback)(uint8_t))
   {
@@ -135,7 +133,7 @@ protected:
   void (*invert_callback_)(uint8_t);
 
   const uint8_t p_, x_, w_;
-  bool inverted_;
+  int8_t overlay_;
 };
 
 class DU_VSEG_Function : public DUINO_Function
@@ -341,8 +339,11 @@ public:
       }
 
       const float filtered_cv = env_lpf_->filter(cv_current_);
-      cv_out(CO1, filtered_cv);
-      cv_out(CO3, filtered_cv / 2.0);
+
+      // convert to millivolts once, rounded, and halve the integer for CO3 (rounding half away from zero)
+      const int16_t mv = lround(filtered_cv * 1000.0);
+      const int16_t out[4] = {mv, 0, int16_t((mv + (mv < 0 ? -1 : 1)) / 2), 0};
+      cv_out_multi(out, (1 << CO1) | (1 << CO3));
     }
     else if (gate_)
     {
@@ -565,12 +566,10 @@ private:
 
   void display_repeat(bool update = true)
   {
-    Display.fill_rect(widget_repeat_->x() + 7, widget_repeat_->y() + 1, 5, 7,
-        widget_repeat_->inverted() ? DUINO_SH1106::White : DUINO_SH1106::Black);
+    Display.fill_rect(widget_repeat_->x() + 7, widget_repeat_->y() + 1, 5, 7, DUINO_SH1106::Black);
 
     const unsigned char c = widget_save_->params.vals.repeat ? '0' + widget_save_->params.vals.repeat : 'C';
-    Display.draw_char(widget_repeat_->x() + 7, widget_repeat_->y() + 1, c,
-        widget_repeat_->inverted() ? DUINO_SH1106::Black : DUINO_SH1106::White);
+    Display.draw_char(widget_repeat_->x() + 7, widget_repeat_->y() + 1, c, DUINO_SH1106::White);
 
     if (update)
     {
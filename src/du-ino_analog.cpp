@@ -0,0 +1,231 @@
+/*
+ * ####                                                ####
+ * ####                                                ####
+ * ####                                                ####      ##
+ * ####                                                ####    ####
+ * ####  ############  ############  ####  ##########  ####  ####
+ * ####  ####    ####  ####    ####  ####  ####        ########
+ * ####  ####    ####  ####    ####  ####  ####        ########
+ * ####  ####    ####  ####    ####  ####  ####        ####  ####
+ * ####  ####    ####  ####    ####  ####  ####        ####    ####
+ * ####  ############  ############  ####  ##########  ####      ####
+ *                             ####                                ####
+ * ################################                                  ####
+ *            __      __              __              __      __       ####
+ *   |  |    |  |    [__)    |_/     (__     |__|    |  |    [__)        ####
+ *   |/\|    |__|    |  \    |  \    .__)    |  |    |__|    |             ##
+ *
+ *
+ * DU-INO Arduino Library - Analog Input Module
+ * Aaron Mavrinac <aaron@logick.ca>
+ */
+
+#include <avr/interrupt.h>
+#include <util/atomic.h>
+#include "du-ino_analog.h"
+
+// ADC clock prescaler of 128 (125 kHz at 16 MHz, 13 clocks per conversion)
+#define ANALOG_PRESCALER               (_BV(ADPS2) | _BV(ADPS1) | _BV(ADPS0))
+
+// ADC auto trigger source: timer/counter 0 overflow
+#define ANALOG_TRIGGER_TIMER0                          _BV(ADTS2)
+
+static inline uint16_t median3(uint16_t a, uint16_t b, uint16_t c)
+{
+  if (a > b)
+  {
+    const uint16_t t = a;
+    a = b;
+    b = t;
+  }
+  return c < a ? a : (c > b ? b : c);
+}
+
+static uint16_t convert(uint8_t channel)
+{
+  ADMUX = channel;
+  ADCSRA |= _BV(ADSC);
+  while (ADCSRA & _BV(ADSC)) { }
+  return ADC;
+}
+
+DUINO_Analog::DUINO_Analog()
+  : channel_(0)
+  , running_(false)
+  , timed_(false)
+  , median_(0)
+{
+  for (uint8_t i = 0; i < ANALOG_CHANNELS; ++i)
+  {
+    samples_[i] = 0;
+    oversampling_[i] = 0;
+    accumulator_[i] = 0;
+    count_[i] = 0;
+    history_[i][0] = history_[i][1] = 0;
+  }
+}
+
+void DUINO_Analog::begin(Trigger trigger)
+{
+  // stop any scan in progress and claim the ADC, then sample with interrupts enabled
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+  {
+    running_ = true;
+    timed_ = trigger == Timer0Overflow;
+
+    // external reference, right adjusted
+    ADCSRA = _BV(ADEN) | _BV(ADIF) | ANALOG_PRESCALER;
+  }
+  while (ADCSRA & _BV(ADSC)) { }
+
+  // the inputs are analog only, so disable their digital input buffers
+  DIDR0 |= (1 << ANALOG_CHANNELS) - 1;
+
+  // fill every channel; anything read in the meantime is the previous result
+  for (uint8_t i = 0; i < ANALOG_CHANNELS; ++i)
+  {
+    const uint16_t sample = convert(i);
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+      samples_[i] = sample << ANALOG_MAX_OVERSAMPLING;
+      history_[i][0] = history_[i][1] = sample;
+      accumulator_[i] = 0;
+      count_[i] = 0;
+    }
+  }
+
+#if ANALOG_SCAN
+  // scan in the background from A0
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+  {
+    channel_ = 0;
+    ADMUX = 0;
+    if (timed_)
+    {
+      ADCSRB = (ADCSRB & ~(_BV(ADTS2) | _BV(ADTS1) | _BV(ADTS0))) | ANALOG_TRIGGER_TIMER0;
+      ADCSRA = _BV(ADEN) | _BV(ADATE) | _BV(ADIF) | _BV(ADIE) | ANALOG_PRESCALER;
+    }
+    else
+    {
+      ADCSRA = _BV(ADEN) | _BV(ADSC) | _BV(ADIF) | _BV(ADIE) | ANALOG_PRESCALER;
+    }
+  }
+#endif
+}
+
+void DUINO_Analog::end()
+{
+  // stop triggering and interrupting, let any conversion in progress finish, and clear its flag
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+  {
+    running_ = false;
+    ADCSRA = _BV(ADEN) | ANALOG_PRESCALER;
+  }
+  while (ADCSRA & _BV(ADSC)) { }
+  ADCSRA = _BV(ADEN) | _BV(ADIF) | ANALOG_PRESCALER;
+  ADCSRB &= ~(_BV(ADTS2) | _BV(ADTS1) | _BV(ADTS0));
+  DIDR0 &= ~((1 << ANALOG_CHANNELS) - 1);
+}
+
+void DUINO_Analog::service()
+{
+  const uint8_t ch = channel_;
+  uint16_t sample = ADC;
+
+  // the multiplexer is only read when a conversion starts, so start the next one before filtering this one
+  channel_ = (ch + 1) & (ANALOG_CHANNELS - 1);
+  ADMUX = channel_;
+
+  if (!timed_)
+  {
+    ADCSRA |= _BV(ADSC);
+  }
+
+  if (median_ & (1 << ch))
+  {
+    const uint16_t filtered = median3(history_[ch][0], history_[ch][1], sample);
+    history_[ch][0] = history_[ch][1];
+    history_[ch][1] = sample;
+    sample = filtered;
+  }
+
+  // sum 4^n samples (at most 64 * 1023, which fits), then decimate to 10 + n bits and scale to 13
+  const uint8_t n = oversampling_[ch];
+  accumulator_[ch] += sample;
+  if (++count_[ch] >> (n << 1))
+  {
+    samples_[ch] = (accumulator_[ch] >> n) << (ANALOG_MAX_OVERSAMPLING - n);
+    accumulator_[ch] = 0;
+    count_[ch] = 0;
+  }
+}
+
+void DUINO_Analog::set_oversampling(uint8_t channel, uint8_t bits, bool median)
+{
+  channel &= ANALOG_CHANNELS - 1;
+
+  start();
+
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+  {
+    oversampling_[channel] = bits > ANALOG_MAX_OVERSAMPLING ? ANALOG_MAX_OVERSAMPLING : bits;
+    if (median)
+    {
+      median_ |= (1 << channel);
+    }
+    else
+    {
+      median_ &= ~(1 << channel);
+    }
+
+    // restart decimation, with the median history primed from the latest result
+    accumulator_[channel] = 0;
+    count_[channel] = 0;
+    history_[channel][0] = history_[channel][1] = samples_[channel] >> ANALOG_MAX_OVERSAMPLING;
+  }
+}
+
+uint16_t DUINO_Analog::read_fine(uint8_t channel)
+{
+  uint16_t sample;
+
+  channel &= ANALOG_CHANNELS - 1;
+
+  start();
+
+#if ANALOG_SCAN
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+  {
+    sample = samples_[channel];
+  }
+#else
+  sample = convert(channel) << ANALOG_MAX_OVERSAMPLING;
+#endif
+
+  return sample;
+}
+
+void DUINO_Analog::start()
+{
+  // only the first caller starts scanning, with interrupts enabled
+  bool stopped;
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+  {
+    stopped = !running_;
+    running_ = true;
+  }
+
+  if (stopped)
+  {
+    begin();
+  }
+}
+
+DUINO_Analog Analog;
+
+#if ANALOG_SCAN
+ISR(ADC_vect)
+{
+  Analog.service();
+}
+#endif
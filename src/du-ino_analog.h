@@ -0,0 +1,118 @@
+/*
+ * ####                                                ####
+ * ####                                                ####
+ * ####                                                ####      ##
+ * ####                                                ####    ####
+ * ####  ############  ############  ####  ##########  ####  ####
+ * ####  ####    ####  ####    ####  ####  ####        ########
+ * ####  ####    ####  ####    ####  ####  ####        ########
+ * ####  ####    ####  ####    ####  ####  ####        ####  ####
+ * ####  ####    ####  ####    ####  ####  ####        ####    ####
+ * ####  ############  ############  ####  ##########  ####      ####
+ *                             ####                                ####
+ * ################################                                  ####
+ *            __      __              __              __      __       ####
+ *   |  |    |  |    [__)    |_/     (__     |__|    |  |    [__)        ####
+ *   |/\|    |__|    |  \    |  \    .__)    |  |    |__|    |             ##
+ *
+ *
+ * DU-INO Arduino Library - Analog Input Module
+ * Aaron Mavrinac <aaron@logick.ca>
+ */
+
+#ifndef DUINO_ANALOG_H_
+#define DUINO_ANALOG_H_
+
+#include "Arduino.h"
+
+#define ANALOG_CHANNELS                                    4
+
+// maximum extra bits of resolution from oversampling (64 samples summed per result)
+#define ANALOG_MAX_OVERSAMPLING                            3
+
+// scan the inputs in the background from the ADC interrupt (ADC_vect); if 0, the vector is left free and each read
+// waits for a conversion of its own, without oversampling
+#define ANALOG_SCAN                                        1
+
+/** Background ADC scanner for analog inputs A0 - A3 (CI1 - CI4). */
+class DUINO_Analog
+{
+public:
+  enum Trigger
+  {
+    Continuous,
+    Timer0Overflow
+  };
+
+  /**
+   * Constructor.
+   */
+  DUINO_Analog();
+
+  /**
+   * Take an initial sample of each channel, then start scanning in the background. This is done by the first read or
+   * set_oversampling() call if not called before. Until end() is called, analogRead() must not be used, as it would
+   * reconfigure the ADC underneath the scanner.
+   *
+   * \param trigger When to start each conversion: Continuous (immediately after the previous one, about 2.4 kHz per
+   *                channel) or Timer0Overflow (on each timer 0 overflow, a fixed 244 Hz per channel).
+   */
+  void begin(Trigger trigger = Continuous);
+
+  /**
+   * Stop scanning and return the ADC to single conversions, as used by analogRead(). The next read or
+   * set_oversampling() call starts scanning again.
+   */
+  void end();
+
+  /**
+   * Store the completed conversion and start the next channel (called by the ADC ISR).
+   */
+  void service();
+
+  /**
+   * Configure oversampling and decimation of a channel, done in the ADC ISR. Each result sums 4^bits samples, for
+   * bits extra bits of resolution (given some noise on the input) at 1/(4^bits) of the sample rate.
+   *
+   * \param channel The channel (0 - 3, for A0 - A3).
+   * \param bits Extra bits of resolution (0 - 3).
+   * \param median If true, replace each sample with the median of it and the two before it, rejecting single-sample
+   *               outliers.
+   */
+  void set_oversampling(uint8_t channel, uint8_t bits, bool median = false);
+
+  /**
+   * Get the latest result of a channel at ADC resolution, without waiting for a conversion.
+   *
+   * \param channel The channel (0 - 3, for A0 - A3).
+   * \return The 10-bit ADC code.
+   */
+  uint16_t read(uint8_t channel) { return read_fine(channel) >> ANALOG_MAX_OVERSAMPLING; }
+
+  /**
+   * Get the latest result of a channel at full oversampled resolution, without waiting for a conversion.
+   *
+   * \param channel The channel (0 - 3, for A0 - A3).
+   * \return The ADC code scaled to 13 bits (0 - 8184); the low bits are zero if the channel is not oversampled.
+   */
+  uint16_t read_fine(uint8_t channel);
+
+private:
+  void start();
+
+  // latest results, scaled to 13 bits
+  volatile uint16_t samples_[ANALOG_CHANNELS];
+  volatile uint8_t channel_;
+  bool running_, timed_;
+
+  // per-channel oversampling bits, median filter enable (bitfield), and running decimation and median state
+  uint8_t oversampling_[ANALOG_CHANNELS];
+  uint8_t median_;
+  uint16_t accumulator_[ANALOG_CHANNELS];
+  uint8_t count_[ANALOG_CHANNELS];
+  uint16_t history_[ANALOG_CHANNELS][2];
+};
+
+extern DUINO_Analog Analog;
+
+#endif // DUINO_ANALOG_H_
@@ -20,46 +20,109 @@
  * Aaron Mavrinac <aaron@logick.ca>
  */
 
-#include <TimerOne.h>
+#include <util/atomic.h>
+#include "du-ino_events.h"
 #include "du-ino_clock.h"
 
-void clock_isr();
+// timer 1 runs freely at F_CPU / 8 (0.5 us per tick), extended to 32 bits by counting overflows
+#define TICKS_PER_US     (F_CPU / 8000000)
+
+// minimum lead for a compare to be set ahead of the counter, in ticks; 8 ticks is 64 CPU cycles at 16 MHz, which
+// must cover reading the counter, clamping the deadline, and writing OCR1A in program() (about 40 cycles), and is
+// doubled until it does if the counter is found to have passed the compare value
+#define MIN_LEAD         8
+
+static volatile uint16_t timer1_overflows = 0;
+
+static uint32_t timer1_now()
+{
+  uint32_t now;
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+  {
+    uint16_t high = timer1_overflows;
+    const uint16_t low = TCNT1;
+
+    // an overflow that its ISR has not counted yet
+    if ((TIFR1 & _BV(TOV1)) && low < 0x8000)
+    {
+      high++;
+    }
+    now = (uint32_t(high) << 16) | low;
+  }
+  return now;
+}
+
+// deadline comparison that holds across wraparound (for deadlines within 17 minutes of each other)
+static inline bool before(uint32_t a, uint32_t b)
+{
+  return int32_t(a - b) < 0;
+}
+
+DUINO_Clock * DUINO_Clock::queue_[CLOCK_MAX];
+uint8_t DUINO_Clock::queue_size_ = 0;
 
 DUINO_Clock::DUINO_Clock()
   : clock_callback_(NULL)
   , external_callback_(NULL)
+  , defer_clock_(false)
+  , defer_external_(false)
   , state_(false)
   , retrigger_flag_(false)
   , swung_(false)
   , external_(false)
   , count_(-1)
-  , swung_ms_(0)
   , period_(0)
   , swing_(0)
   , divider_(1)
   , div_count_(0)
+  , multiplier_(1)
+  , sub_count_(0)
+  , jack_state_(false)
+  , edge_seen_(false)
+  , edge_us_(0)
+  , interval_(0)
+  , outlier_(0)
+  , tick_at_(0)
+  , next_tick_(0)
+  , swing_at_(0)
+  , tick_ticks_(0)
 {
+#if CLOCK_STATS
+  reset_stats();
+#endif
 }
 
 void DUINO_Clock::begin()
 {
-  Timer1.initialize();
-  OCR0A = 0xAF;
+  static bool initialized = false;
+
+  if (!initialized)
+  {
+    // all clocks share timer 1, running freely in normal mode; this disables PWM (analogWrite()) on pins 9 and 10
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+      TCCR1A = 0;
+      TCCR1B = _BV(CS11);
+      TIFR1 = _BV(TOV1) | _BV(OCF1A);
+      TIMSK1 = _BV(TOIE1);
+    }
+    initialized = true;
+  }
 }
 
-void DUINO_Clock::set_period(unsigned long period)
+bool DUINO_Clock::set_period(unsigned long period)
 {
   external_ = false;
   period_ = period;
-  update();
+  return update();
 }
 
-void DUINO_Clock::set_bpm(uint16_t bpm)
+bool DUINO_Clock::set_bpm(uint16_t bpm)
 {
   // clock period is microseconds per 16th note
   // bpm is quarter notes per minute (or 16th notes per 15,000,000 us)
   // halved, for on-off cycle
-  set_period(7500000 / (unsigned long)bpm);
+  return set_period(7500000 / (unsigned long)bpm);
 }
 
 void DUINO_Clock::set_swing(uint8_t swing)
@@ -69,15 +132,6 @@ void DUINO_Clock::set_swing(uint8_t swing)
     swing = 6;
   }
   swing_ = swing;
-
-  if (swing_)
-  {
-    TIMSK0 |= _BV(OCIE0A);
-  }
-  else
-  {
-    TIMSK0 &= ~(_BV(OCIE0A));
-  }
 }
 
 void DUINO_Clock::set_divider(uint8_t divider)
@@ -88,13 +142,43 @@ void DUINO_Clock::set_divider(uint8_t divider)
   }
 }
 
+void DUINO_Clock::set_multiplier(uint8_t multiplier)
+{
+  if (multiplier > 0 && multiplier < 25)
+  {
+    multiplier_ = multiplier;
+    if (!external_)
+    {
+      update();
+    }
+  }
+}
+
 void DUINO_Clock::set_external()
 {
   period_ = 0;
   external_ = true;
+  edge_seen_ = false;
+  interval_ = outlier_ = 0;
   update();
 }
 
+unsigned long DUINO_Clock::get_period() const
+{
+  unsigned long period;
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+  {
+    period = period_;
+  }
+  return period;
+}
+
+uint16_t DUINO_Clock::get_bpm() const
+{
+  const unsigned long period = get_period();
+  return period ? (7500000 + period / 2) / period : 0;
+}
+
 bool DUINO_Clock::retrigger()
 {
   bool flag = retrigger_flag_;
@@ -119,11 +203,31 @@ void DUINO_Clock::on_jack(bool jack_state)
     
     if (external_callback_)
     {
-      external_callback_();
+      if (defer_external_)
+      {
+        Events.push(DUINO_Events::ClockExternal, 0, true, external_callback_);
+      }
+      else
+      {
+        external_callback_();
+      }
     }
   }
 
-  if (state_ != jack_state)
+  if (jack_state && !jack_state_)
+  {
+    measure();
+  }
+  jack_state_ = jack_state;
+
+  if (multiplier_ > 1 && interval_)
+  {
+    if (jack_state)
+    {
+      resync();
+    }
+  }
+  else if (state_ != jack_state)
   {
     on_clock();
   }
@@ -133,9 +237,13 @@ void DUINO_Clock::on_clock()
 {
   if (!external_ && swing_ && !state_ && count_ % 2)
   {
-    // wait an extra (period_ / 1000) * (4 * swing_ / 25) milliseconds on 2 & 4
-    swung_ms_ = millis() + ((period_ * swing_) / 6250);
-    swung_ = true;
+    // wait an extra 4 * swing_ / 25 of the period on 2 & 4, timed from the tick that started this period
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+      swing_at_ = tick_at_ + tick_ticks_ * swing_ * 4 / 25;
+      swung_ = true;
+      schedule(this);
+    }
   }
   else
   {
@@ -143,23 +251,127 @@ void DUINO_Clock::on_clock()
   }
 }
 
-void DUINO_Clock::check_swing()
+void DUINO_Clock::service()
+{
+  // handle every deadline that has passed, earliest first; each clock reschedules itself as needed
+  while (queue_size_ && !before(timer1_now(), queue_[0]->deadline()))
+  {
+    DUINO_Clock * clock = queue_[0];
+#if CLOCK_STATS
+    record(clock->stats_.ticks, clock->stats_.late_min, clock->stats_.late_max, clock->stats_.late_histogram,
+        timer1_now() - clock->deadline());
+#endif
+    unschedule(clock);
+    clock->on_deadline();
+  }
+
+  program();
+}
+
+void DUINO_Clock::measure()
 {
-  if (swung_ && millis() > swung_ms_)
+  const unsigned long now = micros();
+  const unsigned long interval = now - edge_us_;
+  edge_us_ = now;
+
+  if (!edge_seen_)
+  {
+    edge_seen_ = true;
+    return;
+  }
+
+  if (!interval_)
+  {
+    // lock to the first interval
+    interval_ = interval;
+  }
+  else if (interval > interval_ - interval_ / 4 && interval < interval_ + interval_ / 4)
+  {
+    // smooth intervals within 25% of the estimate (exponential moving average, alpha = 1/4)
+    interval_ = interval_ - interval_ / 4 + interval / 4;
+    outlier_ = 0;
+  }
+  else if (outlier_ && interval > outlier_ - outlier_ / 4 && interval < outlier_ + outlier_ / 4)
+  {
+    // two consecutive intervals agree on a new tempo, so lock to it immediately
+    interval_ = interval;
+    outlier_ = 0;
+  }
+  else
+  {
+    // reject a single missed, extra, or stopped edge, but remember it in case the tempo has changed
+    outlier_ = interval;
+    return;
+  }
+
+  // period is the half cycle, as for the internal clock
+  period_ = interval_ / 2;
+}
+
+void DUINO_Clock::resync()
+{
+  // if the edge is early, catch up on the subdivisions still to come, so that each edge is followed by exactly
+  // multiplier_ clock pulses
+  while (sub_count_)
+  {
+    --sub_count_;
+    on_clock();
+  }
+
+  // the edge itself starts the first pulse, and the timer the remaining state changes across the predicted interval
+  on_clock();
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+  {
+    sub_count_ = 2 * multiplier_ - 1;
+    tick_ticks_ = interval_ / (2 * multiplier_) * TICKS_PER_US;
+    tick_at_ = timer1_now();
+    next_tick_ = tick_at_ + tick_ticks_;
+    schedule(this);
+  }
+}
+
+void DUINO_Clock::on_deadline()
+{
+  if (swung_ && before(swing_at_, next_tick_))
   {
     swung_ = false;
+    schedule(this);
     toggle_state();
+    return;
   }
+
+  // the next period starts from this deadline rather than from when it was handled, so latency does not accumulate
+  tick_at_ = next_tick_;
+  next_tick_ += tick_ticks_;
+
+  // subdivisions of an external clock stop after one predicted interval, until the next edge resyncs them
+  if (!external_ || --sub_count_)
+  {
+    schedule(this);
+  }
+
+  on_clock();
 }
 
-void DUINO_Clock::update()
+bool DUINO_Clock::update()
 {
-  Timer1.detachInterrupt();
-  state_ = retrigger_flag_ = false;
-  if (!external_)
+  bool running = true;
+
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
   {
-    Timer1.attachInterrupt(clock_isr, period_);
+    unschedule(this);
+    state_ = retrigger_flag_ = swung_ = false;
+    sub_count_ = 0;
+    if (!external_ && period_)
+    {
+      tick_ticks_ = period_ / multiplier_ * TICKS_PER_US;
+      tick_at_ = timer1_now();
+      next_tick_ = tick_at_ + tick_ticks_;
+      running = schedule(this);
+    }
   }
+
+  return running;
 }
 
 void DUINO_Clock::toggle_state()
@@ -184,18 +396,187 @@ void DUINO_Clock::toggle_state()
 
   if (clock_callback_)
   {
-    clock_callback_();
+    if (defer_clock_)
+    {
+      Events.push(DUINO_Events::ClockEdge, count_, state_, clock_callback_);
+    }
+    else
+    {
+#if CLOCK_STATS
+      const uint32_t start = timer1_now();
+      clock_callback_();
+      record(stats_.callbacks, stats_.callback_min, stats_.callback_max, stats_.callback_histogram,
+          timer1_now() - start);
+#else
+      clock_callback_();
+#endif
+    }
+  }
+}
+
+uint32_t DUINO_Clock::deadline() const
+{
+  return (swung_ && before(swing_at_, next_tick_)) ? swing_at_ : next_tick_;
+}
+
+bool DUINO_Clock::schedule(DUINO_Clock * clock)
+{
+  unschedule(clock);
+
+  // a clock beyond CLOCK_MAX running at once is not queued, and stops until one of the others stops
+  if (queue_size_ == CLOCK_MAX)
+  {
+    return false;
+  }
+
+  // insert in deadline order
+  const uint32_t deadline = clock->deadline();
+  uint8_t i = queue_size_++;
+  for (; i > 0 && before(deadline, queue_[i - 1]->deadline()); --i)
+  {
+    queue_[i] = queue_[i - 1];
+  }
+  queue_[i] = clock;
+
+  program();
+  return true;
+}
+
+void DUINO_Clock::unschedule(DUINO_Clock * clock)
+{
+  uint8_t i = 0;
+  while (i < queue_size_ && queue_[i] != clock)
+  {
+    i++;
+  }
+  if (i == queue_size_)
+  {
+    return;
+  }
+
+  queue_size_--;
+  for (; i < queue_size_; ++i)
+  {
+    queue_[i] = queue_[i + 1];
+  }
+
+  program();
+}
+
+void DUINO_Clock::program()
+{
+  if (!queue_size_)
+  {
+    TIMSK1 &= ~_BV(OCIE1A);
+    return;
+  }
+
+  // compare on the low 16 bits of the earliest deadline; one further away just fires early, and is set again then
+  const uint32_t deadline = queue_[0]->deadline();
+  uint16_t lead = MIN_LEAD;
+  for (;;)
+  {
+    const uint32_t now = timer1_now();
+    const uint32_t at = before(deadline, now + lead) ? now + lead : deadline;
+    TIFR1 = _BV(OCF1A);
+    OCR1A = uint16_t(at);
+
+    // a counter that passed the compare value before it was written would not match it again until it wraps (about
+    // 33 ms later), so set it again further ahead
+    if ((TIFR1 & _BV(OCF1A)) || before(timer1_now(), at))
+    {
+      break;
+    }
+    lead <<= 1;
+  }
+  TIMSK1 |= _BV(OCIE1A);
+}
+
+#if CLOCK_STATS
+void DUINO_Clock::get_stats(DUINO_Clock::Stats & stats) const
+{
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+  {
+    stats = stats_;
+  }
+}
+
+void DUINO_Clock::reset_stats()
+{
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+  {
+    memset(&stats_, 0, sizeof(stats_));
+    stats_.late_min = stats_.callback_min = 0xFFFF;
+  }
+}
+
+static void print_histogram(Print & out, const char * label, uint16_t count, uint16_t min, uint16_t max,
+    const uint16_t * histogram)
+{
+  out.print(label);
+  out.print(count);
+  out.print(" min ");
+  out.print(count ? min : 0);
+  out.print(" max ");
+  out.print(max);
+  out.print(" us |");
+  for (uint8_t i = 0; i < CLOCK_STATS_BUCKETS; ++i)
+  {
+    out.print(' ');
+    out.print(histogram[i]);
+  }
+  out.println();
+}
+
+void DUINO_Clock::print_stats(Print & out) const
+{
+  Stats stats;
+  get_stats(stats);
+  print_histogram(out, "late ", stats.ticks, stats.late_min, stats.late_max, stats.late_histogram);
+  print_histogram(out, "callback ", stats.callbacks, stats.callback_min, stats.callback_max,
+      stats.callback_histogram);
+}
+
+void DUINO_Clock::record(uint16_t & count, uint16_t & min, uint16_t & max, uint16_t * histogram, uint32_t ticks)
+{
+  // saturate, rather than wrap, in microseconds
+  const uint32_t us = ticks / TICKS_PER_US;
+  const uint16_t value = us > 0xFFFF ? 0xFFFF : us;
+
+  if (count < 0xFFFF)
+  {
+    count++;
+  }
+  if (value < min)
+  {
+    min = value;
+  }
+  if (value > max)
+  {
+    max = value;
+  }
+
+  // bucket by bit length: 0, 1, 2 - 3, 4 - 7, ...
+  uint8_t bucket = 0;
+  for (uint16_t v = value; v && bucket < CLOCK_STATS_BUCKETS - 1; v >>= 1)
+  {
+    bucket++;
+  }
+  if (histogram[bucket] < 0xFFFF)
+  {
+    histogram[bucket]++;
   }
 }
+#endif
 
 DUINO_Clock Clock;
 
-void clock_isr()
+ISR(TIMER1_COMPA_vect)
 {
-  Clock.on_clock();
+  DUINO_Clock::service();
 }
 
-ISR(TIMER0_COMPA_vect)
+ISR(TIMER1_OVF_vect)
 {
-  Clock.check_swing();
+  timer1_overflows++;
 }
@@ -25,7 +25,19 @@
 
 #include "Arduino.h"
 
-/** Clock class. */
+// maximum number of clocks running at once, all served from timer 1 in order of their next deadline
+#define CLOCK_MAX                                          4
+
+// record tick lateness and callback duration statistics for each clock (uses 52 bytes of RAM per clock)
+#define CLOCK_STATS                                        0
+
+// statistics histogram buckets: under 1 us, 1 us, 2 - 3 us, 4 - 7 us, and so on up to 256 us and over
+#define CLOCK_STATS_BUCKETS                               10
+
+/**
+ * Clock class. The global Clock object is the usual clock of a function, but further clocks, each with its own period,
+ * swing, divider, multiplier, and callback, can be created and run at the same time (up to CLOCK_MAX).
+ */
 class DUINO_Clock {
  public:
   DUINO_Clock();
@@ -33,18 +45,20 @@ class DUINO_Clock {
   void begin();
 
   /**
-   * Set the period of the clock, in milliseconds.
+   * Set the period of the clock, in microseconds.
    *
-   * \param period The period in milliseconds.
+   * \param period The period (half cycle, or time between state changes) in microseconds.
+   * \return False if the clock cannot run because CLOCK_MAX other clocks are already running.
    */
-  void set_period(unsigned long period);
+  bool set_period(unsigned long period);
 
   /**
    * Set the beats per minute (quarter notes) of the clock.
    *
    * \param bpm Beats per minute (quarter notes).
+   * \return False if the clock cannot run because CLOCK_MAX other clocks are already running.
    */
-  void set_bpm(uint16_t bpm);
+  bool set_bpm(uint16_t bpm);
 
   /**
    * Set the swing delay of the 2 and 4 beats.
@@ -61,7 +75,16 @@ class DUINO_Clock {
   void set_divider(uint8_t divider);
 
   /**
-   * Enable the external clock source.
+   * Set the clock multiplier. An external clock is multiplied by subdividing the tracked period, starting from each
+   * rising edge, so the subdivisions stay in phase with it; each edge is followed by exactly this many pulses.
+   *
+   * \param multiplier The clock multiplier value (1 to 24).
+   */
+  void set_multiplier(uint8_t multiplier);
+
+  /**
+   * Enable the external clock source. The period is then measured from the rising edges passed to on_jack(), and is
+   * zero until two have been seen.
    */
   void set_external();
 
@@ -93,18 +116,50 @@ class DUINO_Clock {
 
   /**
    * Attach a callback to be called when the clock state changes.
+   *
+   * \param callback The callback function.
+   * \param deferred If true, queue the callback to be called from Events.dispatch() in the function loop, rather than
+   *                 calling it from the timer or jack ISR; Events.current().state is then the new clock state.
    */
-  void attach_clock_callback(void (*callback)()) { clock_callback_ = callback; }
+  void attach_clock_callback(void (*callback)(), bool deferred = false)
+  {
+    clock_callback_ = callback;
+    defer_clock_ = deferred;
+  }
 
   /**
    * Attach a callback to be called when the clock switches from internal timer to external input.
+   *
+   * \param callback The callback function.
+   * \param deferred If true, queue the callback to be called from Events.dispatch() in the function loop, rather than
+   *                 calling it from the jack ISR.
    */
-  void attach_external_callback(void (*callback)()) { external_callback_ = callback; }
+  void attach_external_callback(void (*callback)(), bool deferred = false)
+  {
+    external_callback_ = callback;
+    defer_external_ = deferred;
+  }
 
   bool get_external() const { return external_; }
-  unsigned long get_period() const { return period_; }
+
+  /**
+   * Return the period of the clock (internal, or as tracked from the external clock input).
+   *
+   * \return The half cycle (time between state changes) in microseconds, before multiplication and division, or 0 if not
+   * yet known.
+   */
+  unsigned long get_period() const;
+
+  /**
+   * Return the tempo of the clock (internal, or as tracked from the external clock input).
+   *
+   * \return Beats per minute (quarter notes), or 0 if not yet known.
+   */
+  uint16_t get_bpm() const;
+
   uint8_t get_swing() const { return swing_; }
   uint8_t get_divider() const { return divider_; }
+  uint8_t get_multiplier() const { return multiplier_; }
 
   /**
    * Callback method intended to be called by the external clock input jack ISR.
@@ -119,23 +174,87 @@ class DUINO_Clock {
   void on_clock();
 
   /**
-   * Callback method called by the swing timer ISR.
+   * Handle all clock deadlines that have passed (called by the timer ISR).
    */
-  void check_swing();
+  static void service();
+
+#if CLOCK_STATS
+  struct Stats
+  {
+    // deadlines handled, and how long after its deadline each was handled, in microseconds
+    uint16_t ticks;
+    uint16_t late_min, late_max;
+    uint16_t late_histogram[CLOCK_STATS_BUCKETS];
+
+    // callbacks called (not deferred), and how long each took, in microseconds
+    uint16_t callbacks;
+    uint16_t callback_min, callback_max;
+    uint16_t callback_histogram[CLOCK_STATS_BUCKETS];
+  };
+
+  /**
+   * Get the timing statistics recorded since the last reset.
+   *
+   * \param stats The statistics.
+   */
+  void get_stats(Stats & stats) const;
+
+  /**
+   * Reset the timing statistics.
+   */
+  void reset_stats();
+
+  /**
+   * Print the timing statistics recorded since the last reset, e.g. to Serial.
+   *
+   * \param out The output stream.
+   */
+  void print_stats(Print & out) const;
+#endif
 
  protected:
-  void update();
+  bool update();
   void toggle_state();
+  void measure();
+  void resync();
+  void on_deadline();
+
+  uint32_t deadline() const;
+  static bool schedule(DUINO_Clock * clock);
+  static void unschedule(DUINO_Clock * clock);
+  static void program();
+
+  // running clocks, in order of their next deadline
+  static DUINO_Clock * queue_[CLOCK_MAX];
+  static uint8_t queue_size_;
+
+#if CLOCK_STATS
+  static void record(uint16_t & count, uint16_t & min, uint16_t & max, uint16_t * histogram, uint32_t ticks);
+
+  Stats stats_;
+#endif
 
   void (*clock_callback_)();
   void (*external_callback_)();
+  bool defer_clock_, defer_external_;
 
   volatile bool state_, retrigger_flag_, swung_, external_;
   volatile int8_t count_;
-  volatile unsigned long swung_ms_;
 
-  unsigned long period_;
-  uint8_t swing_, divider_, div_count_;
+  volatile unsigned long period_;
+  uint8_t swing_, divider_, div_count_, multiplier_;
+
+  // state changes remaining before the next external clock edge, when multiplying
+  volatile uint8_t sub_count_;
+
+  // external clock tracking: last jack state, time of the last rising edge, smoothed interval between rising edges
+  // (zero until measured), and a rejected interval that the next one may confirm as a tempo change (all in
+  // microseconds)
+  volatile bool jack_state_, edge_seen_;
+  volatile unsigned long edge_us_, interval_, outlier_;
+
+  // start of the current period, next tick, and swung edge (if swung_) deadlines, and the tick period, in timer ticks
+  uint32_t tick_at_, next_tick_, swing_at_, tick_ticks_;
 };
 
 extern DUINO_Clock Clock;
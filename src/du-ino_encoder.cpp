@@ -21,6 +21,8 @@
  */
 
 #include <avr/interrupt.h>
+#include <avr/pgmspace.h>
+#include <util/atomic.h>
 #include "du-ino_encoder.h"
 
 // encoder acceleration configuration for 1000Hz tick
@@ -33,6 +35,13 @@
 #define ENC_DOUBLECLICKTIME                              600
 #define ENC_HOLDTIME                                    1200
 
+// timer 2 counts (at a prescaler of 1024) per button check in pin change mode
+#define ENC_SLOW_TICK            (F_CPU / 1024 * ENC_BUTTONINTERVAL / 1000)
+
+// quadrature steps, indexed by previous state << 2 | current state (states 0 - 3 in rotation order); transitions
+// that skip a state have no known direction, and are ignored
+static const int8_t enc_transitions[16] PROGMEM = {0, 1, 0, -1, -1, 0, 1, 0, 0, -1, 0, 1, 1, 0, -1, 0};
+
 DUINO_Encoder::DUINO_Encoder(uint8_t a, uint8_t b, uint8_t btn)
   : pin_a_(a)
   , pin_b_(b)
@@ -41,6 +50,10 @@ DUINO_Encoder::DUINO_Encoder(uint8_t a, uint8_t b, uint8_t btn)
   , last_(0)
   , acceleration_(0)
   , button_(Open)
+  , pin_change_(false)
+  , pin_in_(NULL)
+  , mask_a_(0)
+  , mask_b_(0)
 {
   // configure pins for active-low operation
   pinMode(pin_a_, INPUT_PULLUP);
@@ -67,15 +80,58 @@ DUINO_Encoder::DUINO_Encoder(uint8_t a, uint8_t b, uint8_t btn)
   TCCR2B &= ~((1 << CS21) | (1 << CS20));
 }
 
-void DUINO_Encoder::begin()
+void DUINO_Encoder::begin(DUINO_Encoder::Mode mode)
 {
-  TCNT2 = 256 - (int)((float)F_CPU * 0.000015625);
+  // pin change mode handles A and B with the port B pin change interrupt
+  const bool port_b = digitalPinToPCMSK(pin_a_) == &PCMSK0 && digitalPinToPCMSK(pin_b_) == &PCMSK0;
+  pin_change_ = mode == PinChange && port_b;
+
+  if (pin_change_)
+  {
+    pin_in_ = portInputRegister(digitalPinToPort(pin_a_));
+    mask_a_ = digitalPinToBitMask(pin_a_);
+    mask_b_ = digitalPinToBitMask(pin_b_);
+
+    // slow tick, once per button check
+    TCCR2B |= (1 << CS22) | (1 << CS21) | (1 << CS20);
+    TCNT2 = 256 - ENC_SLOW_TICK;
+
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+      PCMSK0 |= (1 << digitalPinToPCMSKbit(pin_a_)) | (1 << digitalPinToPCMSKbit(pin_b_));
+      PCIFR = (1 << PCIF0);
+      PCICR |= (1 << PCIE0);
+    }
+  }
+  else
+  {
+    if (port_b)
+    {
+      ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+      {
+        PCMSK0 &= ~((1 << digitalPinToPCMSKbit(pin_a_)) | (1 << digitalPinToPCMSKbit(pin_b_)));
+      }
+    }
+
+    TCCR2B &= ~((1 << CS21) | (1 << CS20));
+    TCNT2 = 256 - (int)((float)F_CPU * 0.000015625);
+  }
+
   TIMSK2 |= (1 << TOIE2);
 }
 
 void DUINO_Encoder::service()
 {
-  bool moved = false;
+  if (pin_change_)
+  {
+    // slow tick: movement is decoded by the pin change ISR, so only decelerate and check the button
+    TCNT2 = 256 - ENC_SLOW_TICK;
+    acceleration_ = acceleration_ > ENC_ACCEL_DEC * ENC_BUTTONINTERVAL
+        ? acceleration_ - ENC_ACCEL_DEC * ENC_BUTTONINTERVAL : 0;
+    check_button();
+    return;
+  }
+
   unsigned long now = millis();
 
   // decelerate each tick
@@ -95,77 +151,95 @@ void DUINO_Encoder::service()
   {
     curr ^= 1;
   }
-  int8_t diff = last_ - curr;
-  if (diff & 1)
+  decode(curr);
+
+  static unsigned long last_button_check = 0;
+
+  // check button
+  if ((now - last_button_check) >= ENC_BUTTONINTERVAL)
+  { 
+    last_button_check = now;
+    check_button();
+  }
+}
+
+void DUINO_Encoder::on_pin_change()
+{
+  // one port read for both pins, decoded as in service()
+  const uint8_t in = *pin_in_;
+  int8_t curr = (in & mask_a_) ? 0 : 3;
+  if (!(in & mask_b_))
   {
-    last_ = curr;
-    delta_ += (diff & 2) - 1;
-    moved = true;
+    curr ^= 1;
   }
+  decode(curr);
+}
 
-  // accelerate if moved
-  if (moved)
+void DUINO_Encoder::decode(int8_t curr)
+{
+  const int8_t step = (int8_t)pgm_read_byte(&enc_transitions[(last_ << 2) | curr]);
+  if (step)
   {
+    last_ = curr;
+    delta_ += step;
+
+    // accelerate if moved
     if (acceleration_ <= (ENC_ACCEL_TOP - ENC_ACCEL_INC))
     {
       acceleration_ += ENC_ACCEL_INC;
     }
   }
+}
 
+void DUINO_Encoder::check_button()
+{
   static uint16_t key_down_ticks = 0;
   static uint8_t double_click_ticks = 0;
-  static unsigned long last_button_check = 0;
 
-  // check button
-  if ((now - last_button_check) >= ENC_BUTTONINTERVAL)
-  { 
-    last_button_check = now;
-    
-    if (digitalRead(pin_btn_) == LOW)
+  if (digitalRead(pin_btn_) == LOW)
+  {
+    key_down_ticks++;
+    if (key_down_ticks > (ENC_HOLDTIME / ENC_BUTTONINTERVAL))
     {
-      key_down_ticks++;
-      if (key_down_ticks > (ENC_HOLDTIME / ENC_BUTTONINTERVAL))
-      {
-        button_ = Held;
-      }
+      button_ = Held;
     }
+  }
 
-    if (digitalRead(pin_btn_) == HIGH)
+  if (digitalRead(pin_btn_) == HIGH)
+  {
+    if (key_down_ticks /*> ENC_BUTTONINTERVAL*/)
     {
-      if (key_down_ticks /*> ENC_BUTTONINTERVAL*/)
+      if (button_ == Held)
+      {
+        button_ = Released;
+        double_click_ticks = 0;
+      }
+      else
       {
-        if (button_ == Held)
+        if (double_click_ticks > 1)
         {
-          button_ = Released;
-          double_click_ticks = 0;
+          if (double_click_ticks < (ENC_DOUBLECLICKTIME / ENC_BUTTONINTERVAL))
+          {
+            button_ = DoubleClicked;
+            double_click_ticks = 0;
+          }
         }
         else
         {
-          if (double_click_ticks > 1)
-          {
-            if (double_click_ticks < (ENC_DOUBLECLICKTIME / ENC_BUTTONINTERVAL))
-            {
-              button_ = DoubleClicked;
-              double_click_ticks = 0;
-            }
-          }
-          else
-          {
-            double_click_ticks = ENC_DOUBLECLICKTIME / ENC_BUTTONINTERVAL;
-          }
+          double_click_ticks = ENC_DOUBLECLICKTIME / ENC_BUTTONINTERVAL;
         }
       }
-
-      key_down_ticks = 0;
     }
-  
-    if (double_click_ticks > 0)
+
+    key_down_ticks = 0;
+  }
+
+  if (double_click_ticks > 0)
+  {
+    double_click_ticks--;
+    if (--double_click_ticks == 0)
     {
-      double_click_ticks--;
-      if (--double_click_ticks == 0)
-      {
-        button_ = Clicked;
-      }
+      button_ = Clicked;
     }
   }
 }
@@ -215,3 +289,10 @@ ISR(TIMER2_OVF_vect)
 {
   Encoder.service();
 }
+
+#if ENCODER_PIN_CHANGE
+ISR(PCINT0_vect)
+{
+  Encoder.on_pin_change();
+}
+#endif
@@ -32,6 +32,10 @@
 
 #include "Arduino.h"
 
+// define the port B pin change interrupt vector (PCINT0_vect) for PinChange mode; off by default, as other libraries
+// (e.g. SoftwareSerial) define the same vector
+#define ENCODER_PIN_CHANGE                                 0
+
 /** Pushbutton encoder controller class. */
 class DUINO_Encoder
 {
@@ -46,6 +50,11 @@ public:
     DoubleClicked
   };
 
+  enum Mode {
+    Polled,
+    PinChange
+  };
+
   /**
    * Constructor.
    *
@@ -57,14 +66,25 @@ public:
 
   /**
    * Initialize the pushbutton encoder controller.
+   *
+   * \param mode How to decode the encoder: Polled (pins read by the tick timer ISR at about 1 kHz) or PinChange (pins
+   *             decoded by the pin change ISR whenever they change, with only the pushbutton read by a 100 Hz tick).
+   *             PinChange requires A and B on port B (digital pins 8 - 13), and otherwise falls back to Polled. It
+   *             also requires the PCINT0_vect ISR, which is defined here only if ENCODER_PIN_CHANGE is set; otherwise
+   *             the sketch must define it to call on_pin_change().
    */
-  void begin();
+  void begin(Mode mode = Polled);
 
   /**
    * Service outstanding events (called by the tick timer ISR).
    */
   void service(void);
 
+  /**
+   * Decode encoder movement (called by the pin change ISR in PinChange mode).
+   */
+  void on_pin_change(void);
+
   /**
    * Get the current delta value (with acceleration) of the encoder.
    *
@@ -80,11 +100,19 @@ public:
   Button get_button(void);
 
 private:
+  inline void decode(int8_t curr);
+  void check_button();
+
   const uint8_t pin_a_, pin_b_, pin_btn_;
 
   volatile int16_t delta_, last_;
   volatile uint16_t acceleration_;
   volatile Button button_;
+
+  // pin change mode, with the input register and bit masks of pins A and B
+  bool pin_change_;
+  volatile uint8_t * pin_in_;
+  uint8_t mask_a_, mask_b_;
 };
 
 extern DUINO_Encoder Encoder;
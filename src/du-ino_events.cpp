@@ -0,0 +1,107 @@
+/*
+ * ####                                                ####
+ * ####                                                ####
+ * ####                                                ####      ##
+ * ####                                                ####    ####
+ * ####  ############  ############  ####  ##########  ####  ####
+ * ####  ####    ####  ####    ####  ####  ####        ########
+ * ####  ####    ####  ####    ####  ####  ####        ########
+ * ####  ####    ####  ####    ####  ####  ####        ####  ####
+ * ####  ####    ####  ####    ####  ####  ####        ####    ####
+ * ####  ############  ############  ####  ##########  ####      ####
+ *                             ####                                ####
+ * ################################                                  ####
+ *            __      __              __              __      __       ####
+ *   |  |    |  |    [__)    |_/     (__     |__|    |  |    [__)        ####
+ *   |/\|    |__|    |  \    |  \    .__)    |  |    |__|    |             ##
+ *
+ *
+ * DU-INO Arduino Library - Event Queue Module
+ * Aaron Mavrinac <aaron@logick.ca>
+ */
+
+#include <util/atomic.h>
+#include "du-ino_events.h"
+
+#if EVENTS_SIZE & (EVENTS_SIZE - 1)
+#error "EVENTS_SIZE must be a power of two"
+#endif
+
+// keep the compiler from moving buffer accesses across an index update
+#define EVENTS_BARRIER()               __asm__ __volatile__("" ::: "memory")
+
+DUINO_Events::DUINO_Events()
+  : head_(0)
+  , tail_(0)
+  , dropped_(0)
+{
+}
+
+bool DUINO_Events::push(uint8_t type, uint8_t data, bool state, void (*callback)())
+{
+  bool pushed = false;
+
+  // ISRs do not nest, so this only excludes pushes from the loop itself
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+  {
+    const uint8_t head = head_;
+    if (uint8_t(head - tail_) < EVENTS_SIZE)
+    {
+      Event & event = buffer_[head & (EVENTS_SIZE - 1)];
+      event.type = type;
+      event.data = data;
+      event.state = state;
+      event.time = micros();
+      event.callback = callback;
+      EVENTS_BARRIER();
+      head_ = head + 1;
+      pushed = true;
+    }
+    else if (dropped_ < 0xFF)
+    {
+      dropped_++;
+    }
+  }
+
+  return pushed;
+}
+
+bool DUINO_Events::pop(Event & event)
+{
+  const uint8_t tail = tail_;
+  if (tail == head_)
+  {
+    return false;
+  }
+
+  EVENTS_BARRIER();
+  event = buffer_[tail & (EVENTS_SIZE - 1)];
+  EVENTS_BARRIER();
+  tail_ = tail + 1;
+
+  return true;
+}
+
+void DUINO_Events::dispatch()
+{
+  while (pop(current_))
+  {
+    if (current_.callback)
+    {
+      current_.callback();
+    }
+  }
+}
+
+uint8_t DUINO_Events::dropped()
+{
+  uint8_t dropped;
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+  {
+    dropped = dropped_;
+    dropped_ = 0;
+  }
+  return dropped;
+}
+
+DUINO_Events Events;
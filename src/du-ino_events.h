@@ -0,0 +1,112 @@
+/*
+ * ####                                                ####
+ * ####                                                ####
+ * ####                                                ####      ##
+ * ####                                                ####    ####
+ * ####  ############  ############  ####  ##########  ####  ####
+ * ####  ####    ####  ####    ####  ####  ####        ########
+ * ####  ####    ####  ####    ####  ####  ####        ########
+ * ####  ####    ####  ####    ####  ####  ####        ####  ####
+ * ####  ####    ####  ####    ####  ####  ####        ####    ####
+ * ####  ############  ############  ####  ##########  ####      ####
+ *                             ####                                ####
+ * ################################                                  ####
+ *            __      __              __              __      __       ####
+ *   |  |    |  |    [__)    |_/     (__     |__|    |  |    [__)        ####
+ *   |/\|    |__|    |  \    |  \    .__)    |  |    |__|    |             ##
+ *
+ *
+ * DU-INO Arduino Library - Event Queue Module
+ * Aaron Mavrinac <aaron@logick.ca>
+ */
+
+#ifndef DUINO_EVENTS_H_
+#define DUINO_EVENTS_H_
+
+#include "Arduino.h"
+
+// number of events the queue can hold (power of two)
+#define EVENTS_SIZE                                        8
+
+/**
+ * Event queue class, for deferring callbacks from interrupt context to the function loop.
+ *
+ * ISRs push timestamped events, each with the callback to call for it, and the function loop calls dispatch() to
+ * call them in order. The queue has a single consumer (the loop), which reads it without disabling interrupts.
+ */
+class DUINO_Events
+{
+public:
+  enum Type
+  {
+    ClockEdge,
+    ClockExternal,
+    GateEdge,
+    User
+  };
+
+  struct Event
+  {
+    uint8_t type;
+    uint8_t data;
+    bool state;
+    unsigned long time;
+    void (*callback)();
+  };
+
+  /**
+   * Constructor.
+   */
+  DUINO_Events();
+
+  /**
+   * Push an event, timestamped with micros(); normally called from an ISR.
+   *
+   * \param type The event type (see Type).
+   * \param data Data identifying the source of the event (e.g. the jack).
+   * \param state The state of the source when the event occurred (e.g. the clock or gate state).
+   * \param callback The callback to call for the event in dispatch(), or NULL.
+   * \return False if the queue was full and the event was dropped.
+   */
+  bool push(uint8_t type, uint8_t data, bool state, void (*callback)());
+
+  /**
+   * Pop the oldest event; must only be called from the function loop.
+   *
+   * \param event The event.
+   * \return False if the queue was empty.
+   */
+  bool pop(Event & event);
+
+  /**
+   * Call the callbacks of all queued events in order; normally called at the top of the function loop.
+   */
+  void dispatch();
+
+  /**
+   * Get the event being dispatched, for callbacks that need its state or time.
+   *
+   * \return The event whose callback is being called by dispatch().
+   */
+  const Event & current() const { return current_; }
+
+  /**
+   * Get the number of events dropped because the queue was full, and reset it.
+   *
+   * \return The number of events dropped since the last call.
+   */
+  uint8_t dropped();
+
+private:
+  Event buffer_[EVENTS_SIZE];
+
+  // the producers (ISRs) only advance head_, and the consumer (loop) only advances tail_
+  volatile uint8_t head_, tail_;
+  volatile uint8_t dropped_;
+
+  Event current_;
+};
+
+extern DUINO_Events Events;
+
+#endif // DUINO_EVENTS_H_
@@ -20,7 +20,15 @@
  * Aaron Mavrinac <aaron@logick.ca>
  */
 
+#include <avr/pgmspace.h>
+#include <util/atomic.h>
+#include <util/crc16.h>
+#include <EEPROM.h>
+#include "du-ino_analog.h"
+#include "du-ino_events.h"
 #include "du-ino_mcp4922.h"
+#include "du-ino_pins.h"
+#include "du-ino_utils.h"
 #include "du-ino_widgets.h"
 #include "du-ino_function.h"
 
@@ -31,15 +39,132 @@
 
 #define STARTUP_DELAY     100 // ms
 #define TRIG_MS           5   // ms
-#define DIGITAL_THRESH    3.0 // V
-#define CV_IN_OFFSET      0.1 // V
+#define TRIG_OCR          0x80
+#define GT_LOCKOUT_MS     1   // ms
+#define DAC_UNKNOWN       0xFFFF // not a 12-bit code, so the first write to each channel is never skipped
+#define DIGITAL_THRESH    3000 // mV
+#define CV_IN_OFFSET      0.1  // V
+
+// GT1 - GT4 are digital pins 0 - 3, which share a port with bit positions equal to the jack numbers
+typedef DUINO_Pin<DUINO_Function::GT1> pin_gt;
+
+// calibration record: magic, prescale and offset for each jack (CO1, CO2, CO4, CO3, CI1 - CI4), and CRC-16 of these
+#define CAL_MAGIC                   0xCA1B
+#define CAL_ENTRIES                 8
+#define CAL_ENTRY_ADDRESS(e, o)     (CALIBRATION_EEPROM_ADDRESS + 2 + (e) * 8 + (o) * 4)
+#define CAL_CRC_ADDRESS             (CALIBRATION_EEPROM_ADDRESS + 2 + CAL_ENTRIES * 8)
+
+// defaults, from du-ino_calibration.h if present, for jacks without a stored calibration
+#ifdef USE_CALIBRATION
+static const float default_prescale[CAL_ENTRIES] PROGMEM =
+    { CO1_PRESCALE, CO2_PRESCALE, CO4_PRESCALE, CO3_PRESCALE, CI1_PRESCALE, CI2_PRESCALE, CI3_PRESCALE, CI4_PRESCALE };
+static const float default_offset[CAL_ENTRIES] PROGMEM =
+    { CO1_OFFSET, CO2_OFFSET, CO4_OFFSET, CO3_OFFSET, CI1_OFFSET, CI2_OFFSET, CI3_OFFSET, CI4_OFFSET };
+#else
+static const float default_prescale[CAL_ENTRIES] PROGMEM = { 1.0, 1.0, 1.0, 1.0, 1.0, 1.0, 1.0, 1.0 };
+static const float default_offset[CAL_ENTRIES] PROGMEM = { 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0 };
+#endif
+
+static float eeprom_read_float(int address)
+{
+  union { float f; uint8_t b[4]; } value;
+  for (uint8_t i = 0; i < 4; ++i)
+  {
+    value.b[i] = EEPROM.read(address + i);
+  }
+  return value.f;
+}
+
+static void eeprom_update_float(int address, float f)
+{
+  union { float f; uint8_t b[4]; } value;
+  value.f = f;
+  for (uint8_t i = 0; i < 4; ++i)
+  {
+    EEPROM.update(address + i, value.b[i]);
+  }
+}
+
+static uint16_t calibration_crc()
+{
+  uint16_t crc = 0xFFFF;
+  for (int a = CAL_ENTRY_ADDRESS(0, 0); a < CAL_CRC_ADDRESS; ++a)
+  {
+    crc = _crc16_update(crc, EEPROM.read(a));
+  }
+  return crc;
+}
+
+static bool calibration_valid()
+{
+  return (EEPROM.read(CALIBRATION_EEPROM_ADDRESS) | (EEPROM.read(CALIBRATION_EEPROM_ADDRESS + 1) << 8)) == CAL_MAGIC
+      && (EEPROM.read(CAL_CRC_ADDRESS) | (EEPROM.read(CAL_CRC_ADDRESS + 1) << 8)) == calibration_crc();
+}
+
+// function whose triggers are ended and GT inputs debounced by the timer 0 compare B interrupt
+static DUINO_Function * trig_function = NULL;
+
+// GT3 and GT4 interrupt callbacks and modes, called again for an edge the lockout held back
+static void (*gt_callback[2])() = {NULL, NULL};
+static int gt_callback_mode[2];
+
+// deferred GT3 and GT4 interrupt callbacks, queued by these ISRs
+static void (*gt_deferred_callback[2])() = {NULL, NULL};
+
+static void gt_defer(DUINO_Function::Jack jack)
+{
+  Events.push(DUINO_Events::GateEdge, jack, trig_function && trig_function->gt_read_debounce(jack),
+      gt_deferred_callback[jack - DUINO_Function::GT3]);
+}
+
+static void gt3_defer_isr() { gt_defer(DUINO_Function::GT3); }
+static void gt4_defer_isr() { gt_defer(DUINO_Function::GT4); }
+
+static inline void gt_write(uint8_t mask, bool on)
+{
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+  {
+    if (on)
+    {
+      pin_gt::port() |= mask;
+    }
+    else
+    {
+      pin_gt::port() &= ~mask;
+    }
+  }
+}
 
 DUINO_Function::DUINO_Function(uint8_t sc)
   : top_level_widget_(NULL)
   , saved_(false)
+  , cv_held_(false)
+  , trig_pending_(0)
+  , trig_level_(0)
+  , gt_state_(0)
+  , gt_rose_(0)
+  , gt_fell_(0)
 {
   set_switch_config(sc);
 
+  for (uint8_t i = 0; i < 8; ++i)
+  {
+    trig_count_[i] = 0;
+    trig_width_[i] = TRIG_MS;
+  }
+
+  for (uint8_t i = 0; i < 4; ++i)
+  {
+    dac_code_[i] = DAC_UNKNOWN;
+    gt_lockout_[i] = 0;
+    gt_edge_time_[i] = 0;
+  }
+
+  for (uint8_t e = 0; e < CAL_ENTRIES; ++e)
+  {
+    calibrate(e, pgm_read_float(&default_prescale[e]), pgm_read_float(&default_offset[e]));
+  }
+
   // configure analog pins
   analogReference(EXTERNAL);
   pinMode(A0, INPUT);
@@ -48,10 +173,8 @@ DUINO_Function::DUINO_Function(uint8_t sc)
   pinMode(A3, INPUT);
 
   // configure DACs
-  for (uint8_t i = 0; i < 2; ++i)
-  {
-    dac_[i] = new DUINO_MCP4922(7 - i, 8);
-  }
+  dac1_ = new DUINO_MCP4922<7, 8>();
+  dac2_ = new DUINO_MCP4922<6, 8>();
 }
 
 void DUINO_Function::begin()
@@ -64,12 +187,27 @@ void DUINO_Function::begin()
     delay(STARTUP_DELAY);
 
     // initialize DACs
-    dac_[0]->begin();
-    dac_[1]->begin();
+    dac1_->begin();
+    dac2_->begin();
+
+    // apply stored calibration, before any CV is read or written
+    load_calibration();
 
     // initialize outputs
     gt_out_multi(0xFF, false);
 
+    // timer 0 is left running by the Arduino core for millis(); its compare B interrupt (about 1 kHz) ends triggers
+    // and debounces GT inputs
+    trig_function = this;
+    OCR0B = TRIG_OCR;
+
+    // take the initial state of the GT inputs without reporting edges, then debounce them from the same interrupt
+    gt_state_ = ~pin_gt::pin() & switch_config_ & 0x0F;
+    if (switch_config_ & 0x0F)
+    {
+      TIMSK0 |= _BV(OCIE0B);
+    }
+
     // initialize display
     Display.begin();
     Display.clear_display(); 
@@ -129,14 +267,14 @@ bool DUINO_Function::gt_read(DUINO_Function::Jack jack)
     case GT4:
       if (switch_config_ & (1 << jack))
       {
-        return digitalRead(jack) == LOW ? true : false;
+        return !(pin_gt::pin() & (1 << jack));
       }
       break;
     case CI1:
     case CI2:
     case CI3:
     case CI4:
-      return cv_read(jack) > DIGITAL_THRESH;
+      return cv_read_mv(jack) > DIGITAL_THRESH;
   }
 
   return false;
@@ -144,19 +282,36 @@ bool DUINO_Function::gt_read(DUINO_Function::Jack jack)
 
 bool DUINO_Function::gt_read_debounce(DUINO_Function::Jack jack)
 {
-  if (switch_config_ & (1 << jack))
+  return jack < CO1 && (gt_read_all() & (1 << jack));
+}
+
+uint8_t DUINO_Function::gt_read_all()
+{
+  gt_update();
+  return gt_state_;
+}
+
+bool DUINO_Function::gt_rose(DUINO_Function::Jack jack)
+{
+  return gt_take_edge(gt_rose_, jack);
+}
+
+bool DUINO_Function::gt_fell(DUINO_Function::Jack jack)
+{
+  return gt_take_edge(gt_fell_, jack);
+}
+
+unsigned long DUINO_Function::gt_edge_time(DUINO_Function::Jack jack)
+{
+  unsigned long t = 0;
+  if (jack < CO1)
   {
-    uint16_t buffer = 0x5555;
-    while (buffer && buffer != 0xFFFF)
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
     {
-      buffer = (buffer << 1) | digitalRead(jack);
+      t = gt_edge_time_[jack];
     }
-    return buffer ? false : true;
-  }
-  else
-  {
-    return false;
   }
+  return t;
 }
 
 void DUINO_Function::gt_out(DUINO_Function::Jack jack, bool on, bool trig)
@@ -169,131 +324,138 @@ void DUINO_Function::gt_out(DUINO_Function::Jack jack, bool on, bool trig)
     case GT4:
       if ((~switch_config_) & (1 << jack))
       {
-        digitalWrite(jack, on ? HIGH : LOW);
-        if (trig)
-        {
-          delay(TRIG_MS);
-          digitalWrite(jack, on ? LOW : HIGH);
-        }
+        trig_start(1 << jack, on, trig);
+        gt_write(1 << jack, on);
       }
       break;
     case CO1:
     case CO2:
     case CO3:
     case CO4:
-      dac_[(jack - 4) >> 1]->output((DUINO_MCP4922::Channel)((jack - 4) & 1), on ? 0xBFF : 0x800);
-      if (trig)
-      {
-        delay(TRIG_MS);
-        dac_[(jack - 4) >> 1]->output((DUINO_MCP4922::Channel)((jack - 4) & 1), on ? 0x800 : 0xBFF);
-      }
+      trig_start(1 << jack, on, trig);
+      dac_output(jack - 4, on ? 0xBFF : 0x800);
       break;
   }
 }
 
 void DUINO_Function::gt_out_multi(uint8_t jacks, bool on, bool trig)
 {
+  // GT outputs change simultaneously with a single port write
+  const uint8_t gt_mask = jacks & (~switch_config_) & 0x0F;
+
+  trig_start(gt_mask | (jacks & 0xF0), on, trig);
+  gt_write(gt_mask, on);
+
+  // CO outputs change simultaneously with a single latch
+  uint16_t data[4];
   for (uint8_t i = 0; i < 4; ++i)
   {
-    if (jacks & (~switch_config_) & (1 << i))
-    {
-      digitalWrite(i, on ? HIGH : LOW);
-    }
+    data[i] = on ? 0xBFF : 0x800;
   }
-  for (uint8_t i = 4; i < 8; ++i)
+  dac_output_multi(jacks >> 4, data);
+}
+
+void DUINO_Function::set_trigger_width(DUINO_Function::Jack jack, uint8_t ms)
+{
+  if (jack < CI1 && ms > 0 && ms < 255)
   {
-    if (jacks & (1 << i))
-    {
-      dac_[(i - 4) >> 1]->output((DUINO_MCP4922::Channel)((i - 4) & 1), on ? 0xBFF : 0x800);
-    }
+    trig_width_[jack] = ms;
   }
+}
 
-  if (trig)
+float DUINO_Function::cv_read(DUINO_Function::Jack jack)
+{
+  return float(cv_read_mv(jack)) * 0.001;
+}
+
+int16_t DUINO_Function::cv_read_mv(DUINO_Function::Jack jack)
+{
+  if (jack < CI1)
   {
-    delay(TRIG_MS);
-    for (uint8_t i = 0; i < 4; ++i)
-    {
-      if (jacks & (~switch_config_) & (1 << i))
-      {
-        digitalWrite(i, on ? LOW : HIGH);
-      }
-    }
-    for (uint8_t i = 4; i < 8; ++i)
-    {
-      if (jacks & (1 << i))
-      {
-        dac_[(i - 4) >> 1]->output((DUINO_MCP4922::Channel)((i - 4) & 1), on ? 0x800 : 0xBFF);
-      }
-    }
+    return 0;
   }
+
+  const uint8_t i = jack - CI1;
+  return (int32_t(Analog.read_fine(i)) * ci_scale_[i] + ci_offset_[i]) >> 13;
 }
 
-float DUINO_Function::cv_read(DUINO_Function::Jack jack)
+uint16_t DUINO_Function::cv_read_raw(DUINO_Function::Jack jack)
 {
-  switch (jack)
+  // latest sample from the background scanner, so this never waits for a conversion
+  return jack < CI1 ? 0 : Analog.read(jack - CI1);
+}
+
+void DUINO_Function::cv_set_oversampling(DUINO_Function::Jack jack, uint8_t bits, bool median)
+{
+  if (jack >= CI1)
   {
-#ifdef USE_CALIBRATION
-    case CI1:
-      return cv_analog_read(A0) * CI1_PRESCALE + CI1_OFFSET;
-    case CI2:
-      return cv_analog_read(A1) * CI2_PRESCALE + CI2_OFFSET;
-    case CI3:
-      return cv_analog_read(A2) * CI3_PRESCALE + CI3_OFFSET;
-    case CI4:
-      return cv_analog_read(A3) * CI4_PRESCALE + CI4_OFFSET;
-#else
-    case CI1:
-      return cv_analog_read(A0);
-    case CI2:
-      return cv_analog_read(A1);
-    case CI3:
-      return cv_analog_read(A2);
-    case CI4:
-      return cv_analog_read(A3);
-#endif
-    default:
-      return 0.0;
+    Analog.set_oversampling(jack - CI1, bits, median);
   }
 }
 
 void DUINO_Function::cv_out(DUINO_Function::Jack jack, float value)
+{
+  // millivolts, rounded, within the range of an int16_t
+  value = clamp<float>(value, -32.0, 32.0) * 1000.0;
+  cv_out_mv(jack, int16_t(value < 0.0 ? value - 0.5 : value + 0.5));
+}
+
+void DUINO_Function::cv_out_mv(DUINO_Function::Jack jack, int16_t mv)
 {
   if (jack == CO1 || jack == CO2 || jack == CO3 || jack == CO4)
   {
-    // (value + 10) * ((2^12 - 1) / 20)
-#ifdef USE_CALIBRATION
-    float calibrated_value;
-    switch (jack)
-    {
-      case CO1:
-        calibrated_value = value * CO1_PRESCALE + CO1_OFFSET;
-      case CO2:
-        calibrated_value = value * CO2_PRESCALE + CO2_OFFSET;
-      case CO3:
-        calibrated_value = value * CO3_PRESCALE + CO3_OFFSET;
-      case CO4:
-        calibrated_value = value * CO4_PRESCALE + CO4_OFFSET;
-    }
-#else
-    const float calibrated_value = value;
-#endif
-    uint16_t data = uint16_t((calibrated_value + 10.0) * 204.75);
+    const uint8_t channel = jack - 4;
+    const int32_t code = (int32_t(mv) * co_scale_[channel] + co_offset_[channel]) >> 16;
+    dac_output(channel, code < 0 ? 0 : (code > 0xFFF ? 0xFFF : code));
+  }
+}
+
+void DUINO_Function::cv_out_raw(DUINO_Function::Jack jack, uint16_t code)
+{
+  if (jack == CO1 || jack == CO2 || jack == CO3 || jack == CO4)
+  {
+    dac_output(jack - 4, code);
+  }
+}
 
-    // DAC output
-    dac_[(jack - 4) >> 1]->output((DUINO_MCP4922::Channel)((jack - 4) & 1), data);
+void DUINO_Function::cv_out_multi(const int16_t * mv, uint8_t jacks)
+{
+  // values are given in CO1 - CO4 order, but DAC channels 0 - 3 are CO1, CO2, CO4, CO3
+  static const uint8_t channel_value[4] = {0, 1, 3, 2};
+
+  uint16_t data[4];
+  for (uint8_t i = 0; i < 4; ++i)
+  {
+    const int32_t code = (int32_t(mv[channel_value[i]]) * co_scale_[i] + co_offset_[i]) >> 16;
+    data[i] = code < 0 ? 0 : (code > 0xFFF ? 0xFFF : code);
   }
+  dac_output_multi(jacks >> 4, data);
 }
 
 void DUINO_Function::cv_hold(bool state)
 {
   // both DACs share the LDAC pin, so holding either will hold all four channels
-  dac_[0]->hold(state);
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+  {
+    cv_held_ = state;
+    dac1_->hold(state);
+  }
 }
 
-void DUINO_Function::gt_attach_interrupt(DUINO_Function::Jack jack, void (*isr)(void), int mode)
+void DUINO_Function::gt_attach_interrupt(DUINO_Function::Jack jack, void (*isr)(void), int mode, bool deferred)
 {
   if (jack == GT3 || jack == GT4)
   {
+    if (deferred)
+    {
+      gt_deferred_callback[jack - GT3] = isr;
+      isr = jack == GT3 ? gt3_defer_isr : gt4_defer_isr;
+    }
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+      gt_callback[jack - GT3] = isr;
+      gt_callback_mode[jack - GT3] = mode;
+    }
     attachInterrupt(digitalPinToInterrupt(jack), isr, mode);
   }
 }
@@ -303,11 +465,132 @@ void DUINO_Function::gt_detach_interrupt(DUINO_Function::Jack jack)
   if (jack == GT3 || jack == GT4)
   {
     detachInterrupt(digitalPinToInterrupt(jack));
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+      gt_callback[jack - GT3] = NULL;
+    }
   }
 }
 
+void DUINO_Function::service()
+{
+  // GT inputs locked out after an edge are sampled again once the lockout expires
+  for (uint8_t i = 0; i < 4; ++i)
+  {
+    if (gt_lockout_[i])
+    {
+      --gt_lockout_[i];
+    }
+  }
+  const uint8_t previous = gt_state_;
+  gt_update();
+
+  // an interrupt callback that read GT3 or GT4 during its lockout saw the old value, so call it again for a change
+  // taken here (unless its own interrupt is still pending, and will see the change itself)
+  const uint8_t changed = gt_state_ ^ previous;
+  for (uint8_t k = 0; k < 2; ++k)
+  {
+    const uint8_t jack = GT3 + k;
+    if ((changed & (1 << jack)) && gt_callback[k] && !(EIFR & _BV(digitalPinToInterrupt(jack))))
+    {
+      // inputs are active low, so the pin falls as the input rises
+      const bool high = gt_state_ & (1 << jack);
+      const int mode = gt_callback_mode[k];
+      if (mode == CHANGE || (mode == FALLING && high) || (mode == RISING && !high))
+      {
+        gt_callback[k]();
+      }
+    }
+  }
+
+  uint8_t ended = 0;
+  for (uint8_t i = 0; i < 8; ++i)
+  {
+    if ((trig_pending_ & (1 << i)) && !--trig_count_[i])
+    {
+      ended |= (1 << i);
+    }
+  }
+
+  if (ended)
+  {
+    end_triggers(ended);
+  }
+
+  if (!trig_pending_ && !(switch_config_ & 0x0F))
+  {
+    TIMSK0 &= ~_BV(OCIE0B);
+  }
+}
+
+void DUINO_Function::end_triggers(uint8_t ended)
+{
+  trig_pending_ &= ~ended;
+
+  // GT jacks end together with a single port write
+  const uint8_t gt_mask = ended & 0x0F;
+  pin_gt::port() = (pin_gt::port() & ~gt_mask) | (trig_level_ & gt_mask);
+
+  // CO jacks end together with a single latch
+  uint16_t data[4];
+  for (uint8_t i = 0; i < 4; ++i)
+  {
+    data[i] = (trig_level_ & (1 << (i + 4))) ? 0xBFF : 0x800;
+  }
+  dac_output_multi(ended >> 4, data);
+}
+
+void DUINO_Function::set_calibration(DUINO_Function::Jack jack, float prescale, float offset, bool store)
+{
+  if (jack < CO1 || jack > CI4)
+  {
+    return;
+  }
+
+  const uint8_t e = jack - CO1;
+  calibrate(e, prescale, offset);
+
+  if (store)
+  {
+    // start a new record from the defaults, so that unset jacks keep them
+    if (!calibration_valid())
+    {
+      for (uint8_t i = 0; i < CAL_ENTRIES; ++i)
+      {
+        eeprom_update_float(CAL_ENTRY_ADDRESS(i, 0), pgm_read_float(&default_prescale[i]));
+        eeprom_update_float(CAL_ENTRY_ADDRESS(i, 1), pgm_read_float(&default_offset[i]));
+      }
+      EEPROM.update(CALIBRATION_EEPROM_ADDRESS, CAL_MAGIC & 0xFF);
+      EEPROM.update(CALIBRATION_EEPROM_ADDRESS + 1, CAL_MAGIC >> 8);
+    }
+
+    eeprom_update_float(CAL_ENTRY_ADDRESS(e, 0), prescale);
+    eeprom_update_float(CAL_ENTRY_ADDRESS(e, 1), offset);
+
+    const uint16_t crc = calibration_crc();
+    EEPROM.update(CAL_CRC_ADDRESS, crc & 0xFF);
+    EEPROM.update(CAL_CRC_ADDRESS + 1, crc >> 8);
+  }
+}
+
+bool DUINO_Function::load_calibration()
+{
+  if (!calibration_valid())
+  {
+    return false;
+  }
+
+  for (uint8_t e = 0; e < CAL_ENTRIES; ++e)
+  {
+    calibrate(e, eeprom_read_float(CAL_ENTRY_ADDRESS(e, 0)), eeprom_read_float(CAL_ENTRY_ADDRESS(e, 1)));
+  }
+
+  return true;
+}
+
 void DUINO_Function::set_switch_config(uint8_t sc)
 {
+  const uint8_t added = trig_function == this ? sc & ~switch_config_ & 0x0F : 0;
   switch_config_ = sc;
 
   // configure digital pins
@@ -315,10 +598,209 @@ void DUINO_Function::set_switch_config(uint8_t sc)
   {
     pinMode(i, sc & (1 << i) ? INPUT : OUTPUT);
   }
+
+  // once running, take the current state of newly configured GT inputs without reporting edges, and make sure they
+  // are debounced (begin() does this for the initial configuration)
+  if (trig_function == this)
+  {
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+      const uint8_t inputs = sc & 0x0F;
+      gt_state_ = (gt_state_ & inputs & ~added) | (~pin_gt::pin() & added);
+      gt_rose_ &= inputs;
+      gt_fell_ &= inputs;
+      if (inputs)
+      {
+        TIMSK0 |= _BV(OCIE0B);
+      }
+    }
+  }
+}
+
+void DUINO_Function::calibrate(uint8_t entry, float prescale, float offset)
+{
+  // fold calibration into integer scales and offsets, so that reads and writes need no floating point
+  uint16_t scale;
+  int32_t offset_fixed;
+  if (entry < 4)
+  {
+    // code = (mV / 1000 + 10) * ((2^12 - 1) / 20), rounded
+    scale = uint16_t(prescale * 0.20475 * 65536.0 + 0.5);
+    offset_fixed = int32_t((offset + 10.0) * 204.75 * 65536.0) + 32768;
+  }
+  else
+  {
+    // mV = code * (20000 / (2^10 - 1)) - 10000 + offset, rounded; the scale is per 13-bit code (one eighth of a 10-bit
+    // code) in Q13, which is numerically the same as per 10-bit code in Q10
+    scale = uint16_t(prescale * (20000.0 / 1023.0) * 1024.0 + 0.5);
+    offset_fixed = int32_t(((-10.0 + CV_IN_OFFSET) * prescale + offset) * 1000.0 * 8192.0) + 4096;
+  }
+
+  // CV may be read or written from ISRs
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+  {
+    if (entry < 4)
+    {
+      co_scale_[entry] = scale;
+      co_offset_[entry] = offset_fixed;
+    }
+    else
+    {
+      ci_scale_[entry - 4] = scale;
+      ci_offset_[entry - 4] = offset_fixed;
+    }
+  }
+}
+
+void DUINO_Function::trig_start(uint8_t jacks, bool on, bool trig)
+{
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+  {
+    if (!trig)
+    {
+      // a gate replaces any trigger in progress
+      trig_pending_ &= ~jacks;
+      return;
+    }
+
+    if (on)
+    {
+      trig_level_ &= ~jacks;
+    }
+    else
+    {
+      trig_level_ |= jacks;
+    }
+
+    // one tick more than the width, since the first tick arrives anywhere up to a tick after the start
+    for (uint8_t i = 0; i < 8; ++i)
+    {
+      if (jacks & (1 << i))
+      {
+        trig_count_[i] = trig_width_[i] + 1;
+      }
+    }
+    trig_pending_ |= jacks;
+
+    TIFR0 = _BV(OCF0B);
+    TIMSK0 |= _BV(OCIE0B);
+  }
+}
+
+void DUINO_Function::gt_update()
+{
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+  {
+    // one port read samples all four inputs, which are active low
+    const uint8_t changed = (~pin_gt::pin() ^ gt_state_) & switch_config_ & 0x0F;
+    if (changed)
+    {
+      const unsigned long now = micros();
+      for (uint8_t i = 0; i < 4; ++i)
+      {
+        // the first edge is taken immediately, and bounces are ignored until the lockout expires
+        if ((changed & (1 << i)) && !gt_lockout_[i])
+        {
+          gt_state_ ^= (1 << i);
+          if (gt_state_ & (1 << i))
+          {
+            gt_rose_ |= (1 << i);
+          }
+          else
+          {
+            gt_fell_ |= (1 << i);
+          }
+          gt_edge_time_[i] = now;
+          gt_lockout_[i] = GT_LOCKOUT_MS + 1;
+        }
+      }
+    }
+  }
+}
+
+bool DUINO_Function::gt_take_edge(volatile uint8_t & edges, DUINO_Function::Jack jack)
+{
+  bool edge = false;
+  if (jack < CO1)
+  {
+    gt_update();
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+      edge = edges & (1 << jack);
+      edges &= ~(1 << jack);
+    }
+  }
+  return edge;
+}
+
+void DUINO_Function::dac_output(uint8_t channel, uint16_t data)
+{
+  data &= 0xFFF;
+
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+  {
+    if (data != dac_code_[channel])
+    {
+      dac_code_[channel] = data;
+      dac_write(channel, data);
+    }
+  }
+}
+
+void DUINO_Function::dac_output_multi(uint8_t channels, const uint16_t * data)
+{
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+  {
+    uint8_t changed = 0;
+    for (uint8_t i = 0; i < 4; ++i)
+    {
+      if ((channels & (1 << i)) && (data[i] & 0xFFF) != dac_code_[i])
+      {
+        changed |= (1 << i);
+      }
+    }
+
+    // hold LDAC across the burst so that the channels change together, unless only one is written or the outputs are
+    // already held with cv_hold()
+    const bool latch = (changed & (changed - 1)) && !cv_held_;
+    if (latch)
+    {
+      dac1_->hold(true);
+    }
+
+    for (uint8_t i = 0; i < 4; ++i)
+    {
+      if (changed & (1 << i))
+      {
+        dac_code_[i] = data[i] & 0xFFF;
+        dac_write(i, dac_code_[i]);
+      }
+    }
+
+    if (latch)
+    {
+      dac1_->hold(false);
+    }
+  }
 }
 
-float DUINO_Function::cv_analog_read(uint8_t pin)
+void DUINO_Function::dac_write(uint8_t channel, uint16_t data)
 {
-  // value * (20 / (2^10 - 1)) - 10
-  return float(analogRead(pin)) * 0.019550342130987292 - 10.0 + CV_IN_OFFSET;
+  // channels 0 - 3 are CO1, CO2, CO4, CO3
+  if (channel & 2)
+  {
+    dac2_->output((DUINO_MCP4922<6, 8>::Channel)(channel & 1), data);
+  }
+  else
+  {
+    dac1_->output((DUINO_MCP4922<7, 8>::Channel)(channel & 1), data);
+  }
+}
+
+ISR(TIMER0_COMPB_vect)
+{
+  if (trig_function)
+  {
+    trig_function->service();
+  }
 }
@@ -27,7 +27,11 @@
 #include "du-ino_sh1106.h"
 #include "du-ino_encoder.h"
 
-class DUINO_MCP4922;
+// EEPROM bytes reserved at the top for the calibration record (see DUINO_Function::set_calibration())
+#define CALIBRATION_EEPROM_SIZE                           68
+#define CALIBRATION_EEPROM_ADDRESS                        (E2END + 1 - CALIBRATION_EEPROM_SIZE)
+
+template <uint8_t SS, uint8_t LDAC> class DUINO_MCP4922;
 class DUINO_Widget;
 
 /** Main function controller base class. */
@@ -93,16 +97,52 @@ public:
   bool gt_read(Jack jack);
 
   /**
-   * Read a gate/trigger input, with software debounce.
+   * Read a gate/trigger input, with software debounce. The first edge on an input is taken immediately, and further
+   * changes are ignored for a 1 ms lockout; the inputs are also sampled in the background about once per millisecond.
+   * Takes constant time, so it is safe to call from an ISR.
    *
-   * \param jack The input jack to read.
-   * \return The digital value of the input.
+   * \param jack The input jack to read (GT1 - GT4).
+   * \return The debounced digital value of the input.
    */
   bool gt_read_debounce(Jack jack);
 
+  /**
+   * Read all gate/trigger inputs, with software debounce (see gt_read_debounce()).
+   *
+   * \return The debounced digital values of GT1 - GT4, as a bitfield by jack (always 0 for jacks configured as outputs).
+   */
+  uint8_t gt_read_all();
+
+  /**
+   * Check for and clear a rising edge (gate on) of a debounced gate/trigger input.
+   *
+   * \param jack The input jack (GT1 - GT4).
+   * \return True if the input has risen since the last call.
+   */
+  bool gt_rose(Jack jack);
+
+  /**
+   * Check for and clear a falling edge (gate off) of a debounced gate/trigger input.
+   *
+   * \param jack The input jack (GT1 - GT4).
+   * \return True if the input has fallen since the last call.
+   */
+  bool gt_fell(Jack jack);
+
+  /**
+   * Get the time of the last edge of a debounced gate/trigger input.
+   *
+   * \param jack The input jack (GT1 - GT4).
+   * \return The time of the last rising or falling edge, in microseconds (see micros()).
+   */
+  unsigned long gt_edge_time(Jack jack);
+
   /**
    * Output a gate or trigger signal.
    *
+   * Triggers return immediately; the opposite value is output from the trigger timer ISR once the jack's trigger
+   * width has elapsed. Outputting a gate on a jack cancels any trigger in progress on it.
+   *
    * \param jack The output jack.
    * \param on The value of the gate/trigger signal (on if true, off if false).
    * \param trig Trigger; if true, output the specified value briefly, then output the opposite value.
@@ -118,6 +158,14 @@ public:
    */
   void gt_out_multi(uint8_t jacks, bool on, bool trig = false);
 
+  /**
+   * Set the trigger pulse width of an output jack (5 ms by default).
+   *
+   * \param jack The output jack.
+   * \param ms The trigger width, in milliseconds (1 - 254).
+   */
+  void set_trigger_width(Jack jack, uint8_t ms);
+
   /**
    * Read a CV input.
    *
@@ -126,6 +174,32 @@ public:
    */
   float cv_read(Jack jack);
 
+  /**
+   * Read a CV input in millivolts, using integer arithmetic only. Oversampled inputs (see cv_set_oversampling()) are
+   * read at their full resolution.
+   *
+   * \param jack The input jack to read.
+   * \return The CV value, in millivolts.
+   */
+  int16_t cv_read_mv(Jack jack);
+
+  /**
+   * Read the raw, uncalibrated ADC code of a CV input.
+   *
+   * \param jack The input jack to read.
+   * \return The 10-bit ADC code (0 = -10 V, 1023 = +10 V).
+   */
+  uint16_t cv_read_raw(Jack jack);
+
+  /**
+   * Oversample and decimate a CV input in the background, for up to 13 bits (about 2.4 mV) of resolution.
+   *
+   * \param jack The input jack.
+   * \param bits Extra bits of resolution (0 - 3); each result averages 4^bits samples.
+   * \param median If true, reject single-sample outliers with a 3-sample median filter before decimation.
+   */
+  void cv_set_oversampling(Jack jack, uint8_t bits, bool median = false);
+
   /**
    * Output a CV value.
    *
@@ -134,6 +208,31 @@ public:
    */
   void cv_out(Jack jack, float value);
 
+  /**
+   * Output a CV value in millivolts, using integer arithmetic only.
+   *
+   * \param jack The output jack.
+   * \param mv The CV value, in millivolts.
+   */
+  void cv_out_mv(Jack jack, int16_t mv);
+
+  /**
+   * Output a raw, uncalibrated DAC code.
+   *
+   * \param jack The output jack.
+   * \param code The 12-bit DAC code (0 = -10 V, 4095 = +10 V).
+   */
+  void cv_out_raw(Jack jack, uint16_t code);
+
+  /**
+   * Output CV values in millivolts to multiple jacks simultaneously. Jacks whose DAC code is unchanged are skipped, and
+   * the rest are written back to back and released together in a single latch.
+   *
+   * \param mv The CV values, in millivolts, for CO1, CO2, CO3, and CO4 (in that order).
+   * \param jacks The output jacks to update, as a bitfield; e.g. (1 << CO1) | (1 << CO3).
+   */
+  void cv_out_multi(const int16_t * mv, uint8_t jacks = (1 << CO1) | (1 << CO2) | (1 << CO3) | (1 << CO4));
+
   /**
    * Hold CV outputs; used to set multiple values with cv_out() then release them simultaneously.
    *
@@ -141,6 +240,24 @@ public:
    */
   void cv_hold(bool state);
 
+  /**
+   * Set the calibration of a CV jack, applied as value * prescale + offset (in volts) to what is read from an input
+   * or before it is written to an output. Jacks default to du-ino_calibration.h if present, or no correction.
+   *
+   * \param jack The CV jack (CO1 - CO4 or CI1 - CI4).
+   * \param prescale The scale factor.
+   * \param offset The offset, in volts.
+   * \param store If true, also store it in the calibration record in EEPROM, so that begin() applies it from then on.
+   */
+  void set_calibration(Jack jack, float prescale, float offset, bool store = false);
+
+  /**
+   * Apply the calibration record stored in EEPROM (called by begin()).
+   *
+   * \return True if a valid record was found and applied.
+   */
+  bool load_calibration();
+
   /**
    * Attach an interrupt callback to a jack with hardware interrupt capability.
    *
@@ -149,8 +266,10 @@ public:
    * \param jack The interrupt jack (GT3 or GT4).
    * \param isr The interrupt service routine function pointer.
    * \param mode When the interrupt should be triggered (LOW, CHANGE, RISING, FALLING).
+   * \param deferred If true, queue the callback to be called from Events.dispatch() in the function loop, rather than
+   *                 calling it from the ISR; Events.current().state is then the debounced input value at the interrupt.
    */
-  void gt_attach_interrupt(Jack jack, void (*isr)(void), int mode);
+  void gt_attach_interrupt(Jack jack, void (*isr)(void), int mode, bool deferred = false);
 
   /**
    * Detach an interrupt callback from a jack.
@@ -179,15 +298,52 @@ public:
    */
   void set_switch_config(uint8_t sc);
 
+  /**
+   * Debounce GT inputs and end triggers whose width has elapsed (called by the timer ISR about once per millisecond).
+   */
+  void service();
+
  protected:
-  inline float cv_analog_read(uint8_t pin);
+  void trig_start(uint8_t jacks, bool on, bool trig);
+  void end_triggers(uint8_t ended);
+  void gt_update();
+  bool gt_take_edge(volatile uint8_t & edges, Jack jack);
+  void calibrate(uint8_t entry, float prescale, float offset);
+
+  void dac_output(uint8_t channel, uint16_t data);
+  void dac_output_multi(uint8_t channels, const uint16_t * data);
+  inline void dac_write(uint8_t channel, uint16_t data);
 
-  DUINO_MCP4922 * dac_[2];
+  // DAC1 (CO1, CO2) and DAC2 (CO4, CO3), with chip select on pins 7 and 6 and a shared LDAC on pin 8
+  DUINO_MCP4922<7, 8> * dac1_;
+  DUINO_MCP4922<6, 8> * dac2_;
 
   DUINO_Widget * top_level_widget_;
 
   bool saved_;
   uint8_t switch_config_;
+
+  // last code written to each DAC channel (0 - 3), and whether the outputs are held with cv_hold()
+  uint16_t dac_code_[4];
+  bool cv_held_;
+
+  // calibration folded into fixed-point scales and offsets: millivolts from 13-bit ADC codes for CI1 - CI4 (Q13), and
+  // DAC codes from millivolts for DAC channels 0 - 3 (Q16)
+  uint16_t ci_scale_[4], co_scale_[4];
+  int32_t ci_offset_[4], co_offset_[4];
+
+  // output jacks (as a bitfield) with a trigger in progress, the value each returns to when it ends, and the timer
+  // ticks remaining and configured for each
+  volatile uint8_t trig_pending_;
+  uint8_t trig_level_;
+  volatile uint8_t trig_count_[8];
+  uint8_t trig_width_[8];
+
+  // debounced GT input values and unread rising and falling edges (bitfields by jack), and the timer ticks of lockout
+  // remaining and time in microseconds of the last edge for each
+  volatile uint8_t gt_state_, gt_rose_, gt_fell_;
+  volatile uint8_t gt_lockout_[4];
+  volatile unsigned long gt_edge_time_[4];
 };
 
 #endif // DUINO_FUNCTION_H_
@@ -24,8 +24,12 @@
 #define DUINO_MCP4922_H_
 
 #include "Arduino.h"
+#include <SPI.h>
+#include <util/atomic.h>
+#include "du-ino_pins.h"
 
-/** MCP4922 DAC driver class. */
+/** MCP4922 DAC driver class template. */
+template <uint8_t SS, uint8_t LDAC>
 class DUINO_MCP4922 {
 public:
   enum Channel
@@ -35,36 +39,73 @@ public:
   };
 
   /**
-   * Constructor.
-   *
-   * \param ss Address of the chip select pin for this device.
-   * \param ldac Address of the LDAC (hold) pin for this device.
+   * Constructor. The chip select (SS) and LDAC (hold) pins are given as template parameters.
    */
-  DUINO_MCP4922(uint8_t ss, uint8_t ldac);
+  DUINO_MCP4922()
+  {
+    // configure chip select for output
+    pin_ss::output();
+    pin_ldac::output();
+  }
 
   /**
    * Initialize the MCP4922 DAC device.
    */
-  void begin();
+  void begin()
+  {
+    // hold chip deselect
+    pin_ss::high();
+
+    // hold LDAC low
+    pin_ldac::low();
+
+    // configure SPI
+    SPI.begin();
+    SPI.setBitOrder(MSBFIRST);
+    SPI.setDataMode(SPI_MODE0);
+    SPI.setClockDivider(SPI_CLOCK_DIV2);
+  }
 
   /**
-   * Output the specified digital value to the specified channel.
+   * Output the specified digital value to the specified channel. Safe to call from an ISR, as the transfer is atomic.
    *
    * \param channel The output channel (A or B).
    * \param data The raw digital data value.
    */
-  void output(Channel channel, uint16_t data);
+  void output(Channel channel, uint16_t data)
+  {
+    // truncate to 12 bits
+    data &= 0xfff;
+    // add control bits
+    data |= (channel << 15) | 0x7000;
+
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+      // chip select
+      pin_ss::low();
+
+      // send command
+      SPI.transfer((data & 0xff00) >> 8);
+      SPI.transfer(data & 0xff);
+
+      // chip deselect
+      pin_ss::high();
+    }
+  }
 
   /**
    * Hold or release the current output value of both channels.
    *
    * \param state If true, hold the current value on both channels until called with false.
    */
-  void hold(bool state);
+  void hold(bool state)
+  {
+    pin_ldac::write(state);
+  }
 
 private:
-  const uint8_t pin_ss_;
-  const uint8_t pin_ldac_;
+  typedef DUINO_Pin<SS> pin_ss;
+  typedef DUINO_Pin<LDAC> pin_ldac;
 };
 
-#endif // DUINO_FUNCTION_H_
+#endif // DUINO_MCP4922_H_
@@ -0,0 +1,60 @@
+/*
+ * ####                                                ####
+ * ####                                                ####
+ * ####                                                ####      ##
+ * ####                                                ####    ####
+ * ####  ############  ############  ####  ##########  ####  ####
+ * ####  ####    ####  ####    ####  ####  ####        ########
+ * ####  ####    ####  ####    ####  ####  ####        ########
+ * ####  ####    ####  ####    ####  ####  ####        ####  ####
+ * ####  ####    ####  ####    ####  ####  ####        ####    ####
+ * ####  ############  ############  ####  ##########  ####      ####
+ *                             ####                                ####
+ * ################################                                  ####
+ *            __      __              __              __      __       ####
+ *   |  |    |  |    [__)    |_/     (__     |__|    |  |    [__)        ####
+ *   |/\|    |__|    |  \    |  \    .__)    |  |    |__|    |             ##
+ *
+ * DU-INO Arduino Library - Fast Digital Pin Module
+ * Aaron Mavrinac <aaron@logick.ca>
+ */
+
+#ifndef DUINO_PINS_H_
+#define DUINO_PINS_H_
+
+#include "Arduino.h"
+
+#if !defined(__AVR_ATmega328P__) && !defined(__AVR_ATmega168__)
+#error "DU-INO fast pin mapping is only defined for ATmega328P/168 (Arduino Uno) boards"
+#endif
+
+/**
+ * Digital pin class template, resolving the Arduino pin number to its port register and bit at compile time.
+ *
+ * With a constant pin number, each of the accessors below compiles down to a single sbi, cbi, or sbic/sbis
+ * instruction, rather than the table lookups of digitalWrite() and digitalRead().
+ */
+template <uint8_t P>
+class DUINO_Pin
+{
+public:
+  static inline volatile uint8_t & port() { return P < 8 ? PORTD : (P < 14 ? PORTB : PORTC); }
+  static inline volatile uint8_t & ddr() { return P < 8 ? DDRD : (P < 14 ? DDRB : DDRC); }
+  static inline volatile uint8_t & pin() { return P < 8 ? PIND : (P < 14 ? PINB : PINC); }
+  static inline uint8_t bit() { return P < 8 ? P : (P < 14 ? P - 8 : P - 14); }
+  static inline uint8_t mask() { return 1 << bit(); }
+
+  static inline void output() { ddr() |= mask(); }
+  static inline void input() { ddr() &= ~mask(); }
+
+  static inline void high() { port() |= mask(); }
+  static inline void low() { port() &= ~mask(); }
+  static inline void write(bool state) { if (state) { high(); } else { low(); } }
+
+  static inline bool read() { return pin() & mask(); }
+
+private:
+  static_assert(P < 20, "DUINO_Pin is only defined for digital pins 0 - 19");
+};
+
+#endif // DUINO_PINS_H_
@@ -81,7 +81,7 @@ public:
   void mark_changed()
   {
     saved_ = false;
-    Display.fill_rect(x_ + 2, y_ + 2, 3, 3, inverted() ? DUINO_SH1106::White : DUINO_SH1106::Black);
+    Display.fill_rect(x_ + 2, y_ + 2, 3, 3, DUINO_SH1106::Black);
   }
 
   Parameters params;
@@ -90,7 +90,7 @@ protected:
   void mark_saved()
   {
     saved_ = true;
-    Display.fill_rect(x_ + 2, y_ + 2, 3, 3, inverted() ? DUINO_SH1106::Black : DUINO_SH1106::White);
+    Display.fill_rect(x_ + 2, y_ + 2, 3, 3, DUINO_SH1106::White);
   }
 
   const int address_;
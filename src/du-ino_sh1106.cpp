@@ -24,35 +24,164 @@
 #include <SPI.h>
 #include <avr/pgmspace.h>
 #include <util/atomic.h>
+#include <util/crc16.h>
 #include "du-ino_font5x7.h"
+#include "du-ino_pins.h"
 #include "du-ino_sh1106.h"
 
-static uint8_t buffer[SH1106_LCDHEIGHT * SH1106_LCDWIDTH / 8];
+typedef DUINO_Pin<SH1106_PIN_SS> pin_ss;
+typedef DUINO_Pin<SH1106_PIN_DC> pin_dc;
 
-DUINO_SH1106::DUINO_SH1106(uint8_t ss, uint8_t dc)
-  : pin_ss_(ss)
-  , pin_dc_(dc)
+static uint8_t buffer[SH1106_BUFFER_PAGES * SH1106_LCDWIDTH];
+
+static inline void blend_byte(register uint8_t * bp, register uint8_t bits, register uint8_t mask,
+    DUINO_SH1106::Color color)
+{
+  // apply sprite bits to a single buffer byte, treating pixels under the mask as opaque
+  switch (color)
+  {
+    case DUINO_SH1106::Black:
+      *bp = (*bp & ~mask) | (mask & ~bits);
+      break;
+    case DUINO_SH1106::White:
+      *bp = (*bp & ~mask) | bits;
+      break;
+    case DUINO_SH1106::Inverse:
+      *bp ^= bits;
+      break;
+  }
+}
+
+static inline void fill_span(register uint8_t * bp, register uint8_t w, register uint8_t mask,
+    DUINO_SH1106::Color color)
+{
+  // apply a page mask to a horizontal run of buffer bytes
+  switch (color)
+  {
+    case DUINO_SH1106::Black:
+      if (mask == 0xFF)
+      {
+        memset(bp, 0x00, w);
+        break;
+      }
+      mask = ~mask;
+      while (w--)
+      {
+        *bp++ &= mask;
+      }
+      break;
+    case DUINO_SH1106::White:
+      if (mask == 0xFF)
+      {
+        memset(bp, 0xFF, w);
+        break;
+      }
+      while (w--)
+      {
+        *bp++ |= mask;
+      }
+      break;
+    case DUINO_SH1106::Inverse:
+      while (w--)
+      {
+        *bp++ ^= mask;
+      }
+      break;
+  }
+}
+
+static inline int16_t line_minor_steps(int16_t k, int16_t du, int16_t dv, int16_t err0)
 {
-  pinMode(pin_ss_, OUTPUT);
-  pinMode(pin_dc_, OUTPUT);
+  // minor axis steps taken before major step k of a Bresenham line with initial error err0
+  const int32_t t = (int32_t)k * dv - err0;
+  return t > 0 ? (t + du - 1) / du : 0;
+}
+
+static bool clip_line_steps(int16_t u1, int16_t v1, int16_t du, int16_t dv, int8_t vstep, int16_t err0,
+    int16_t u_min, int16_t u_max, int16_t v_min, int16_t v_max, int16_t & k_start, int16_t & k_end)
+{
+  // major axis bounds apply to the step index directly
+  int32_t ks = (u_min > u1) ? u_min - u1 : 0;
+  int32_t ke = (u_max - u1 < du) ? u_max - u1 : du;
+
+  // minor axis bounds limit the number of minor steps, which never decreases with the step index
+  const int16_t n_min = vstep > 0 ? v_min - v1 : v1 - v_max;
+  const int16_t n_max = vstep > 0 ? v_max - v1 : v1 - v_min;
+  if (n_max < 0)
+  {
+    return false;
+  }
+  if (n_min > 0)
+  {
+    const int32_t k = ((int32_t)(n_min - 1) * du + err0) / dv + 1;
+    if (k > ks)
+    {
+      ks = k;
+    }
+  }
+  const int32_t k = ((int32_t)n_max * du + err0) / dv;
+  if (k < ke)
+  {
+    ke = k;
+  }
+
+  k_start = ks;
+  k_end = ke;
+  return ks <= ke;
+}
+
+static inline uint8_t page_rows(int16_t row_start, int16_t row_end, uint8_t page)
+{
+  // mask of the rows between row_start and row_end (inclusive) that fall on this page
+  const int16_t page_start = page * 8;
+  if (row_start < page_start)
+  {
+    row_start = page_start;
+  }
+  if (row_end > page_start + 7)
+  {
+    row_end = page_start + 7;
+  }
+  if (row_start > row_end)
+  {
+    return 0x00;
+  }
+  return (0xFF << (row_start & 7)) & (0xFF >> (7 - (row_end & 7)));
+}
+
+DUINO_SH1106::DUINO_SH1106()
+  : buffer_pages_(SH1106_BUFFER_PAGES)
+  , window_top_(0)
+  , window_bottom_(SH1106_BUFFER_PAGES * 8)
+  , start_line_(0)
+  , rendering_(false)
+  , render_callback_(NULL)
+{
+  pin_ss::output();
+  pin_dc::output();
+
+  // display contents are unknown until the first full flush
+  mark_all_dirty();
+
+  memset(overlays_, 0, sizeof(overlays_));
 }
 
 void DUINO_SH1106::sh1106_command(uint8_t command)
 {
-  digitalWrite(pin_ss_, HIGH);
-  digitalWrite(pin_dc_, LOW);
-  digitalWrite(pin_ss_, LOW);
+  pin_ss::high();
+  pin_dc::low();
+  pin_ss::low();
   (void)SPI.transfer(command);
-  digitalWrite(pin_ss_, HIGH);
+  pin_ss::high();
 }
 
 void DUINO_SH1106::begin()
 {
   // hold chip deselect
-  digitalWrite(pin_ss_, HIGH);
+  pin_ss::high();
 
   // hold DC low
-  digitalWrite(pin_dc_, LOW);
+  pin_dc::low();
 
   // initialize SPI
   SPI.begin();
@@ -69,6 +198,7 @@ void DUINO_SH1106::begin()
   sh1106_command(SH1106_SETDISPLAYOFFSET);
   sh1106_command(0x00);
   sh1106_command(SH1106_SETSTARTLINE);
+  start_line_ = 0;
   sh1106_command(SH1106_SEGREMAP | 0x01);
   sh1106_command(SH1106_COMSCANDEC);
   sh1106_command(SH1106_SETCOMPINS);
@@ -82,36 +212,91 @@ void DUINO_SH1106::begin()
   sh1106_command(SH1106_DISPLAYALLON_RESUME);
   sh1106_command(SH1106_NORMALDISPLAY);
   sh1106_command(SH1106_DISPLAYON);
+
+#if SH1106_SKIP_UNCHANGED
+  // panel RAM is undefined after initialization
+  memset(hash_valid_, 0, sizeof(hash_valid_));
+#endif
 }
 
 void DUINO_SH1106::display(uint8_t col_start, uint8_t col_end, uint8_t page_start, uint8_t page_end)
 {
+  uint8_t page, block_start, col, slice_end;
+
+  // clip the region to the display
+  if (col_end >= SH1106_LCDWIDTH)
+  {
+    col_end = SH1106_LCDWIDTH - 1;
+  }
+  if (page_end >= SH1106_LCDHEIGHT / 8)
+  {
+    page_end = SH1106_LCDHEIGHT / 8 - 1;
+  }
+  if (col_start > col_end || page_start > page_end)
+  {
+    return;
+  }
+
+  // any dirty span entirely within the region will be clean once it is sent
   ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
   {
-    uint8_t page, col, b;
     for (page = page_start; page <= page_end; ++page)
     {
-      sh1106_command(SH1106_SETPAGEADDR | page);
-      sh1106_command(SH1106_SETLOWCOLUMN | (col_start + 2) & 0x0F);
-      sh1106_command(SH1106_SETHIGHCOLUMN | (col_start + 2) >> 4);
-      
-      digitalWrite(pin_ss_, HIGH);
-      digitalWrite(pin_dc_, HIGH);
-      digitalWrite(pin_ss_, LOW);
+      if (dirty_col_start_[page] >= col_start && dirty_col_end_[page] <= col_end)
+      {
+        dirty_col_start_[page] = 0xFF;
+        dirty_col_end_[page] = 0x00;
+      }
+    }
+  }
+
+  while (page_start <= page_end)
+  {
+    // in paged mode, render as many pages as the buffer holds before sending them
+    if (paged())
+    {
+      render_window(page_start);
+    }
 
-      b = 1;
-      for (col = col_start; col <= col_end; ++col, ++b)
+    for (page = page_start; page <= page_end && page < window_bottom_ / 8; ++page)
+    {
+      for (block_start = col_start & ~(SH1106_HASH_BLOCK - 1); block_start <= col_end && block_start < SH1106_LCDWIDTH;
+           block_start += SH1106_HASH_BLOCK)
       {
-        (void)SPI.transfer(buffer[page * SH1106_LCDWIDTH + col]);
-        if (b % 16)
+        // compose the block as it should appear on the panel, so that exactly what is hashed is sent even if the
+        // buffer changes
+        uint8_t block[SH1106_HASH_BLOCK];
+        compose_block(page, block_start, block);
+
+        const uint8_t first = col_start > block_start ? col_start : block_start;
+        const uint8_t last = col_end < (block_start + SH1106_HASH_BLOCK - 1) ? col_end
+                                                                             : block_start + SH1106_HASH_BLOCK - 1;
+
+#if SH1106_SKIP_UNCHANGED
+        if (!block_changed(page, block_start, first, last, block))
         {
-          digitalWrite(pin_ss_, HIGH);
-          digitalWrite(pin_ss_, LOW);
+          continue;
         }
-      }
+#endif
 
-      digitalWrite(pin_ss_, HIGH);
+        // send in short column slices, each in its own atomic block, so that interrupts (and any DAC transfers
+        // they make) are serviced between slices rather than held off for the entire region
+        for (col = first; col <= last; col = slice_end + 1)
+        {
+          slice_end = col | (SH1106_FLUSH_SLICE - 1);
+          if (slice_end > last)
+          {
+            slice_end = last;
+          }
+
+          ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+          {
+            display_slice(page, col, slice_end, block + (col - block_start));
+          }
+        }
+      }
     }
+    page_start = page;
   }
 }
 
@@ -120,13 +305,139 @@ void DUINO_SH1106::display()
   display(0, 127, 0, 7);
 }
 
+void DUINO_SH1106::flush()
+{
+  // send only the modified column span of each page
+  uint8_t page = 0;
+  while (page < SH1106_LCDHEIGHT / 8)
+  {
+    uint8_t col_start, col_end;
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+      col_start = dirty_col_start_[page];
+      col_end = dirty_col_end_[page];
+    }
+
+    if (col_start > col_end)
+    {
+      ++page;
+      continue;
+    }
+
+    // in paged mode, merge runs of modified pages that fit in the buffer so they are rendered together
+    uint8_t page_end = page;
+    while (paged() && (page_end + 1) < SH1106_LCDHEIGHT / 8 && (page_end + 1 - page) < buffer_pages_)
+    {
+      uint8_t next_start, next_end;
+      ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+      {
+        next_start = dirty_col_start_[page_end + 1];
+        next_end = dirty_col_end_[page_end + 1];
+      }
+      if (next_start > next_end)
+      {
+        break;
+      }
+      col_start = min(col_start, next_start);
+      col_end = max(col_end, next_end);
+      ++page_end;
+    }
+
+    display(col_start, col_end, page, page_end);
+    page = page_end + 1;
+  }
+}
+
+void DUINO_SH1106::set_buffer_pages(uint8_t pages)
+{
+  // use fewer pages of the buffer than it holds (not while rendering), after which all of it is redrawn
+  if (pages > 0 && pages <= SH1106_BUFFER_PAGES && !rendering_)
+  {
+    buffer_pages_ = pages;
+    window_top_ = 0;
+    window_bottom_ = pages * 8;
+    memset(buffer, 0, sizeof(buffer));
+    mark_all_dirty();
+  }
+}
+
+void DUINO_SH1106::attach_render_callback(void (*callback)())
+{
+  render_callback_ = callback;
+}
+
+int8_t DUINO_SH1106::add_overlay(uint8_t x, uint8_t y, uint8_t width, uint8_t height, OverlayStyle style)
+{
+  if (!width || !height || x >= SH1106_LCDWIDTH || y >= SH1106_LCDHEIGHT)
+  {
+    return -1;
+  }
+
+  for (int8_t i = 0; i < SH1106_OVERLAYS; ++i)
+  {
+    if (!overlays_[i].width)
+    {
+      ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+      {
+        overlays_[i].x = x;
+        overlays_[i].y = y;
+        overlays_[i].width = width;
+        overlays_[i].height = height;
+        overlays_[i].style = style;
+      }
+      mark_overlay_dirty(overlays_[i]);
+      return i;
+    }
+  }
+
+  return -1;
+}
+
+void DUINO_SH1106::remove_overlay(int8_t overlay)
+{
+  if (overlay < 0 || overlay >= SH1106_OVERLAYS || !overlays_[overlay].width)
+  {
+    return;
+  }
+
+  mark_overlay_dirty(overlays_[overlay]);
+  overlays_[overlay].width = 0;
+}
+
+void DUINO_SH1106::scroll(int8_t rows)
+{
+  // the rows exposed are the ones that wrap around from the other edge of the panel
+  const uint8_t count = min(abs(rows), SH1106_LCDHEIGHT);
+  const uint8_t first = (rows > 0 ? start_line_ : start_line_ + rows) & (SH1106_LCDHEIGHT - 1);
+
+  // clear them in the buffer; they are sent by the next flush
+  fill_rect(0, first, SH1106_LCDWIDTH, count, Black);
+  if (first + count > SH1106_LCDHEIGHT)
+  {
+    fill_rect(0, 0, SH1106_LCDWIDTH, first + count - SH1106_LCDHEIGHT, Black);
+  }
+
+  // move the panel's start line, which shifts everything else on screen without any transfer
+  start_line_ = (start_line_ + rows) & (SH1106_LCDHEIGHT - 1);
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+  {
+    sh1106_command(SH1106_SETSTARTLINE | start_line_);
+  }
+}
+
 void DUINO_SH1106::clear_display()
 {
   // clear buffer
-  memset(buffer, 0, SH1106_LCDHEIGHT * SH1106_LCDWIDTH / 8);
+  memset(buffer, 0, buffer_pages_ * SH1106_LCDWIDTH);
+  mark_all_dirty();
 }
 
 void DUINO_SH1106::draw_pixel(int16_t x, int16_t y, Color color)
+{
+  pixel(x, y, color, true);
+}
+
+inline void DUINO_SH1106::pixel(int16_t x, int16_t y, Color color, bool mark)
 {
   // bound check
   if ((x < 0) || (x >= SH1106_LCDWIDTH) || (y < 0) || (y >= SH1106_LCDHEIGHT))
@@ -134,6 +445,18 @@ void DUINO_SH1106::draw_pixel(int16_t x, int16_t y, Color color)
     return;
   }
 
+  if (mark)
+  {
+    mark_dirty(x, x, y / 8, y / 8);
+  }
+
+  // clip to buffer window
+  if ((y < window_top_) || (y >= window_bottom_))
+  {
+    return;
+  }
+  y -= window_top_;
+
   // set pixel value
   switch (color)
   {
@@ -174,37 +497,25 @@ void DUINO_SH1106::draw_hline(int16_t x, int16_t y, int16_t w, Color color)
     return;
   }
 
-  // initialize buffer pointer
-  register uint8_t * bp = buffer + ((y / 8) * SH1106_LCDWIDTH) + x;
-
-  // initialize pixel mask
-  register uint8_t mask = 1 << (y & 7);
+  mark_dirty(x, x + w - 1, y / 8, y / 8);
 
-  switch (color)
+  // clip to buffer window
+  if ((y < window_top_) || (y >= window_bottom_))
   {
-    case Black:
-      mask = ~mask;
-      while (w--)
-      {
-        *bp++ &= mask;
-      }
-      break;
-    case White:
-      while (w--)
-      {
-        *bp++ |= mask;
-      }
-      break;
-    case Inverse:
-      while (w--)
-      {
-        *bp++ ^= mask;
-      }
-      break;
+    return;
   }
+  y -= window_top_;
+
+  // fill a single row of the page
+  fill_span(buffer + ((y / 8) * SH1106_LCDWIDTH) + x, w, 1 << (y & 7), color);
 }
 
 void DUINO_SH1106::draw_vline(int16_t x, int16_t y, int16_t h, Color color)
+{
+  vline(x, y, h, color, true);
+}
+
+inline void DUINO_SH1106::vline(int16_t x, int16_t y, int16_t h, Color color, bool mark)
 {
   // bound check
   if ((x < 0) || (x >= SH1106_LCDWIDTH))
@@ -229,6 +540,16 @@ void DUINO_SH1106::draw_vline(int16_t x, int16_t y, int16_t h, Color color)
     return;
   }
 
+  if (mark)
+  {
+    mark_dirty(x, x, y / 8, (y + h - 1) / 8);
+  }
+
+  if (!clip_window(y, h))
+  {
+    return;
+  }
+
   // use local byte registers for coordinates
   register uint8_t ry = y;
   register uint8_t rh = h;
@@ -348,58 +669,146 @@ void DUINO_SH1106::draw_line(int16_t x1, int16_t y1, int16_t x2, int16_t y2, Col
   }
   else
   {
-    int16_t steep = abs(y2 - y1) > abs(x2 - x1);
+    const bool steep = abs(y2 - y1) > abs(x2 - x1);
 
-    if (steep)
+    // step along the major axis (u) in increasing order, stepping the minor axis (v) as the error term dictates
+    int16_t u1 = steep ? y1 : x1, u2 = steep ? y2 : x2;
+    int16_t v1 = steep ? x1 : y1, v2 = steep ? x2 : y2;
+    if (u1 > u2)
     {
-      const int16_t t1 = y1;
-      const int16_t t2 = y2;
-      y1 = x1;
-      y2 = x2;
-      x1 = t1;
-      x2 = t2;
+      const int16_t tu = u2;
+      const int16_t tv = v2;
+      u2 = u1;
+      v2 = v1;
+      u1 = tu;
+      v1 = tv;
     }
 
-    if (x1 > x2)
+    const int16_t du = u2 - u1;
+    const int16_t dv = abs(v2 - v1);
+    const int8_t vstep = (v1 < v2) ? 1 : -1;
+    const int16_t err0 = du / 2;
+
+    // clip the range of steps to the display
+    int16_t k_start, k_end;
+    if (!(steep ? clip_line_steps(u1, v1, du, dv, vstep, err0, 0, SH1106_LCDHEIGHT - 1, 0, SH1106_LCDWIDTH - 1,
+                                  k_start, k_end)
+                : clip_line_steps(u1, v1, du, dv, vstep, err0, 0, SH1106_LCDWIDTH - 1, 0, SH1106_LCDHEIGHT - 1,
+                                  k_start, k_end)))
     {
-      const int16_t tx = x2;
-      const int16_t ty = y2;
-      x2 = x1;
-      y2 = y1;
-      x1 = tx;
-      y1 = ty;
+      return;
     }
 
-    const int16_t dx = x2 - x1;
-    const int16_t dy = abs(y2 - y1);
-
-    int16_t err = dx / 2;
-    int16_t ystep;
-
-    if (y1 < y2)
+    int16_t v_start = v1 + vstep * line_minor_steps(k_start, du, dv, err0);
+    int16_t v_end = v1 + vstep * line_minor_steps(k_end, du, dv, err0);
+    if (vstep < 0)
     {
-      ystep = 1;
+      const int16_t t = v_start;
+      v_start = v_end;
+      v_end = t;
+    }
+    if (steep)
+    {
+      mark_dirty(v_start, v_end, (u1 + k_start) / 8, (u1 + k_end) / 8);
     }
     else
     {
-      ystep = -1;
+      mark_dirty(u1 + k_start, u1 + k_end, v_start / 8, v_end / 8);
+    }
+
+    // clip again to the rows held in the buffer
+    if (paged() && !(steep ? clip_line_steps(u1, v1, du, dv, vstep, err0, window_top_, window_bottom_ - 1, 0,
+                                             SH1106_LCDWIDTH - 1, k_start, k_end)
+                           : clip_line_steps(u1, v1, du, dv, vstep, err0, 0, SH1106_LCDWIDTH - 1, window_top_,
+                                             window_bottom_ - 1, k_start, k_end)))
+    {
+      return;
     }
 
-    for (; x1 <= x2; x1++)
+    // set up the starting point and error term
+    const int16_t n = line_minor_steps(k_start, du, dv, err0);
+    int16_t err = err0 - (int32_t)k_start * dv + (int32_t)n * du;
+    const int16_t u = u1 + k_start;
+    const int16_t v = v1 + vstep * n;
+    const uint8_t x = steep ? v : u;
+    const uint8_t y = (steep ? u : v) - window_top_;
+
+    register uint8_t * bp = buffer + ((y / 8) * SH1106_LCDWIDTH) + x;
+    register uint8_t bit = 1 << (y & 7);
+    register int16_t k = k_end - k_start + 1;
+
+    if (steep)
     {
-      if (steep)
+      // collect vertical runs into one mask per byte
+      register uint8_t acc = 0;
+      while (k--)
       {
-        draw_pixel(y1, x1, color);
+        acc |= bit;
+        bit <<= 1;
+        err -= dv;
+        const bool vstepped = err < 0;
+        if (vstepped)
+        {
+          err += du;
+        }
+        if (!bit || vstepped)
+        {
+          blend_byte(bp, acc, acc, color);
+          acc = 0;
+        }
+        if (!bit)
+        {
+          bit = 1;
+          bp += SH1106_LCDWIDTH;
+        }
+        if (vstepped)
+        {
+          bp += vstep;
+        }
       }
-      else
+      if (acc)
       {
-        draw_pixel(x1, y1, color);
+        blend_byte(bp, acc, acc, color);
+      }
+    }
+    else
+    {
+      // fill horizontal runs within a single row
+      register uint8_t * run = bp;
+      register uint8_t len = 0;
+      while (k--)
+      {
+        ++len;
+        err -= dv;
+        if (err < 0)
+        {
+          err += du;
+          fill_span(run, len, bit, color);
+          run += len;
+          len = 0;
+          if (vstep > 0)
+          {
+            bit <<= 1;
+            if (!bit)
+            {
+              bit = 0x01;
+              run += SH1106_LCDWIDTH;
+            }
+          }
+          else
+          {
+            bit >>= 1;
+            if (!bit)
+            {
+              bit = 0x80;
+              run -= SH1106_LCDWIDTH;
+            }
+          }
+        }
       }
-      err -= dy;
-      if (err < 0)
+      if (len)
       {
-        y1 += ystep;
-        err += dx;
+        fill_span(run, len, bit, color);
       }
     }
   }
@@ -411,6 +820,10 @@ void DUINO_SH1106::draw_circle(int16_t xc, int16_t yc, int16_t r, Color color)
   register int8_t y = r;
   register int8_t d = 3 - 2 * r;
 
+  // mark the bounding box once, rather than each pixel; a zero radius still steps one pixel out diagonally
+  const int16_t m = r > 0 ? r : 1;
+  mark_rect(xc - m, yc - m, 2 * m + 1, 2 * m + 1);
+
   // Bresenham raster circle algorithm
   while (y >= x)
   {
@@ -436,6 +849,9 @@ void DUINO_SH1106::fill_circle(int16_t xc, int16_t yc, int16_t r, Color color)
   register int8_t y = r;
   register int8_t d = 3 - 2 * r;
 
+  const int16_t m = r > 0 ? r : 1;
+  mark_rect(xc - m, yc - m, 2 * m + 1, 2 * m + 1);
+
   // same as draw_circle, but vlines instead of locus pixels
   while (y >= x)
   {
@@ -457,11 +873,61 @@ void DUINO_SH1106::fill_circle(int16_t xc, int16_t yc, int16_t r, Color color)
 
 void DUINO_SH1106::fill_rect(int16_t x, int16_t y, int16_t w, int16_t h, Color color)
 {
-  // draw filled rectangle as a series of vlines
-  for (int16_t i = x; i < x + w; ++i)
+  // clip at edges of display
+  if (x < 0)
+  {
+    w += x;
+    x = 0;
+  }
+  if (y < 0)
+  {
+    h += y;
+    y = 0;
+  }
+  if ((x + w) > SH1106_LCDWIDTH)
+  {
+    w = (SH1106_LCDWIDTH - x);
+  }
+  if ((y + h) > SH1106_LCDHEIGHT)
+  {
+    h = (SH1106_LCDHEIGHT - y);
+  }
+
+  // check size
+  if ((w <= 0) || (h <= 0))
+  {
+    return;
+  }
+
+  mark_dirty(x, x + w - 1, y / 8, (y + h - 1) / 8);
+
+  if (!clip_window(y, h))
   {
-    draw_vline(i, y, h, color);
+    return;
+  }
+
+  const uint8_t page_start = y / 8;
+  const uint8_t page_end = (y + h - 1) / 8;
+
+  // partial masks for the top and bottom pages
+  const uint8_t top_mask = 0xFF << (y & 7);
+  const uint8_t bottom_mask = 0xFF >> (7 - ((y + h - 1) & 7));
+
+  // fill page by page
+  register uint8_t * bp = buffer + (page_start * SH1106_LCDWIDTH) + x;
+  if (page_start == page_end)
+  {
+    fill_span(bp, w, top_mask & bottom_mask, color);
+    return;
   }
+
+  fill_span(bp, w, top_mask, color);
+  for (uint8_t page = page_start + 1; page < page_end; ++page)
+  {
+    bp += SH1106_LCDWIDTH;
+    fill_span(bp, w, 0xFF, color);
+  }
+  fill_span(bp + SH1106_LCDWIDTH, w, bottom_mask, color);
 }
 
 void DUINO_SH1106::fill_screen(Color color)
@@ -471,77 +937,84 @@ void DUINO_SH1106::fill_screen(Color color)
 }
 
 void DUINO_SH1106::draw_char(int16_t x, int16_t y, unsigned char c, Color color)
+{
+  // draw columns from ASCII 5x7 font map
+  draw_sprite(x, y, 5, 8, &font5x7[c * 5], NULL, color);
+}
+
+void DUINO_SH1106::draw_text(int16_t x, int16_t y, const char * text, Color color)
 {
   // bound check
-  if (((x + 5) < 0) || (x >= SH1106_LCDWIDTH) || ((y + 7) < 0) || (y >= SH1106_LCDHEIGHT))
+  if (((y + 8) <= 0) || (y >= SH1106_LCDHEIGHT))
   {
     return;
   }
 
-  // draw pixels from ASCII 5x7 font map
-  for (int8_t i = 0; i < 5; ++i)
+  // draw characters with 1-pixel spacing, stopping at the right edge
+  while (*text && (x < SH1106_LCDWIDTH))
   {
-    uint8_t line = pgm_read_byte(&font5x7[c * 5 + i]);
-    for (int8_t j = 0; j < 8; ++j, line >>= 1)
-    {
-      if (line & 1)
-      {
-        draw_pixel(x + i, y + j, color);
-      }
-    }
+    draw_char(x, y, *text++, color);
+    x += 6;
   }
 }
 
-void DUINO_SH1106::draw_text(int16_t x, int16_t y, const char * text, Color color)
+void DUINO_SH1106::draw_bitmap_7(int16_t x, int16_t y, const unsigned char * map, unsigned char c, Color color)
 {
-  // draw characters with 1-pixel spacing
-  register int8_t i = 0;
-  while (*(text + i))
-  {
-    draw_char(x + 6 * i++, y, *(text + i), color);
-  }
+  // draw columns from map
+  draw_sprite(x, y, 7, 7, &map[c * 7], NULL, color);
 }
 
-void DUINO_SH1106::draw_bitmap_7(int16_t x, int16_t y, const unsigned char * map, unsigned char c, Color color)
+void DUINO_SH1106::draw_bitmap_8(int16_t x, int16_t y, const unsigned char * map, unsigned char c, Color color)
+{
+  // draw columns from map
+  draw_sprite(x, y, 8, 8, &map[c * 8], NULL, color);
+}
+
+void DUINO_SH1106::draw_sprite(int16_t x, int16_t y, int16_t w, int16_t h, const unsigned char * map,
+    const unsigned char * mask, Color color)
 {
   // bound check
-  if (((x + 7) < 0) || (x >= SH1106_LCDWIDTH) || ((y + 7) < 0) || (y >= SH1106_LCDHEIGHT))
+  if ((w <= 0) || (h <= 0) || ((x + w) <= 0) || (x >= SH1106_LCDWIDTH) || ((y + h) <= 0) || (y >= SH1106_LCDHEIGHT))
   {
     return;
   }
 
-  // draw pixels from map
-  for (int8_t i = 0; i < 7; ++i)
+  // clip at edges of display
+  const int16_t stride = w;
+  if (x < 0)
   {
-    uint8_t line = pgm_read_byte(&map[c * 7 + i]);
-    for (int8_t j = 0; j < 7; ++j, line >>= 1)
+    map -= x;
+    if (mask)
     {
-      if (line & 1)
-      {
-        draw_pixel(x + i, y + j, color);
-      }
+      mask -= x;
     }
+    w += x;
+    x = 0;
   }
-}
-
-void DUINO_SH1106::draw_bitmap_8(int16_t x, int16_t y, const unsigned char * map, unsigned char c, Color color)
-{
-  // bound check
-  if (((x + 8) < 0) || (x >= SH1106_LCDWIDTH) || ((y + 8) < 0) || (y >= SH1106_LCDHEIGHT))
+  if ((x + w) > SH1106_LCDWIDTH)
   {
-    return;
+    w = (SH1106_LCDWIDTH - x);
   }
 
-  // draw pixels from map
-  for (int8_t i = 0; i < 8; ++i)
+  mark_dirty(x, x + w - 1, y < 0 ? 0 : y / 8,
+      (y + h) > SH1106_LCDHEIGHT ? (SH1106_LCDHEIGHT / 8 - 1) : (y + h - 1) / 8);
+
+  // blit each band of eight sprite rows
+  for (int16_t row = 0; row < h; row += 8)
   {
-    uint8_t line = pgm_read_byte(&map[c * 8 + i]);
-    for (int8_t j = 0; j < 8; ++j, line >>= 1)
+    if ((y + row) >= SH1106_LCDHEIGHT)
     {
-      if (line & 1)
-      {
-        draw_pixel(x + i, y + j, color);
-      }
+      break;
+    }
+    if ((y + row + 8) > 0)
+    {
+      draw_band(x, y + row, w, map, mask, (h - row) < 8 ? 0xFF >> (8 - (h - row)) : 0xFF, color);
+    }
+
+    map += stride;
+    if (mask)
+    {
+      mask += stride;
     }
   }
 }
@@ -601,22 +1074,319 @@ void DUINO_SH1106::draw_logick_logo(int16_t x, int16_t y, Color color)
 
 inline void DUINO_SH1106::draw_quadrants(int16_t xc, int16_t yc, int16_t x, int16_t y, Color color)
 {
-  draw_pixel(xc + x, yc + y, color);
-  draw_pixel(xc + x, yc - y, color);
-  draw_pixel(xc + y, yc + x, color);
-  draw_pixel(xc + y, yc - x, color);
-  draw_pixel(xc - x, yc + y, color);
-  draw_pixel(xc - x, yc - y, color);
-  draw_pixel(xc - y, yc + x, color);
-  draw_pixel(xc - y, yc - x, color);
+  pixel(xc + x, yc + y, color, false);
+  pixel(xc + x, yc - y, color, false);
+  pixel(xc + y, yc + x, color, false);
+  pixel(xc + y, yc - x, color, false);
+  pixel(xc - x, yc + y, color, false);
+  pixel(xc - x, yc - y, color, false);
+  pixel(xc - y, yc + x, color, false);
+  pixel(xc - y, yc - x, color, false);
 }
 
 inline void DUINO_SH1106::fill_quadrants(int16_t xc, int16_t yc, int16_t x, int16_t y, Color color)
 {
-  draw_vline(xc + x, yc - y, y + y, color);
-  draw_vline(xc + y, yc - x, x + x, color);
-  draw_vline(xc - x, yc - y, y + y, color);
-  draw_vline(xc - y, yc - x, x + x, color);
+  vline(xc + x, yc - y, y + y, color, false);
+  vline(xc + y, yc - x, x + x, color, false);
+  vline(xc - x, yc - y, y + y, color, false);
+  vline(xc - y, yc - x, x + x, color, false);
+}
+
+inline void DUINO_SH1106::draw_band(int16_t x, int16_t y, int16_t w, const unsigned char * map,
+    const unsigned char * mask, uint8_t rows, Color color)
+{
+  // each band covers at most two pages: the one containing y (if in the window) and the next (if y is unaligned)
+  y -= window_top_;
+  const int8_t page = y >> 3;
+  const int8_t pages = (window_bottom_ - window_top_) / 8;
+  const uint8_t shift = y & 7;
+  register uint8_t * upper = (page >= 0 && page < pages) ? buffer + (page * SH1106_LCDWIDTH) + x : NULL;
+  register uint8_t * lower = (shift && page >= -1 && (page + 1) < pages) ?
+      buffer + ((page + 1) * SH1106_LCDWIDTH) + x : NULL;
+
+  // blend shifted column bytes into the buffer
+  for (uint8_t i = 0; i < w; ++i)
+  {
+    const uint8_t b = pgm_read_byte(&map[i]) & rows;
+    const uint8_t m = mask ? pgm_read_byte(&mask[i]) & rows : b;
+    const uint16_t bits = (uint16_t)(b & m) << shift;
+    const uint16_t keep = (uint16_t)m << shift;
+    if (upper)
+    {
+      blend_byte(upper + i, bits, keep, color);
+    }
+    if (lower)
+    {
+      blend_byte(lower + i, bits >> 8, keep >> 8, color);
+    }
+  }
+}
+
+inline void DUINO_SH1106::compose_block(uint8_t page, uint8_t block_start, uint8_t * block)
+{
+  memcpy(block, buffer + (page - window_top_ / 8) * SH1106_LCDWIDTH + block_start, SH1106_HASH_BLOCK);
+
+  // invert overlay pixels on the way out, leaving the buffer untouched
+  for (uint8_t i = 0; i < SH1106_OVERLAYS; ++i)
+  {
+    const Overlay & o = overlays_[i];
+    if (!o.width || block_start > o.x + o.width - 1 || block_start + SH1106_HASH_BLOCK - 1 < o.x
+        || page * 8 > o.y + o.height - 1 || page * 8 + 7 < o.y)
+    {
+      continue;
+    }
+
+    for (uint8_t j = 0; j < SH1106_HASH_BLOCK; ++j)
+    {
+      const uint8_t col = block_start + j;
+      if (col >= o.x && col <= o.x + o.width - 1)
+      {
+        block[j] ^= overlay_column(o, page, col);
+      }
+    }
+  }
+}
+
+inline void DUINO_SH1106::display_slice(uint8_t page, uint8_t col_start, uint8_t col_end, const uint8_t * data)
+{
+  // set the address on every slice, since an interrupt may have flushed another region in between
+  sh1106_command(SH1106_SETPAGEADDR | page);
+  sh1106_command(SH1106_SETLOWCOLUMN | ((col_start + 2) & 0x0F));
+  sh1106_command(SH1106_SETHIGHCOLUMN | ((col_start + 2) >> 4));
+
+  pin_ss::high();
+  pin_dc::high();
+  pin_ss::low();
+
+  register const uint8_t * bp = data;
+  for (uint8_t col = col_start; col < col_end; ++col)
+  {
+    (void)SPI.transfer(*bp++);
+    pin_ss::high();
+    pin_ss::low();
+  }
+  (void)SPI.transfer(*bp);
+
+  pin_ss::high();
+}
+
+#if SH1106_SKIP_UNCHANGED
+bool DUINO_SH1106::block_changed(uint8_t page, uint8_t block_start, uint8_t col_start, uint8_t col_end,
+    const uint8_t * data)
+{
+  const uint8_t block = block_start / SH1106_HASH_BLOCK;
+  const uint8_t bit = 1 << block;
+  const uint8_t block_end = block_start + SH1106_HASH_BLOCK - 1;
+
+  // hash the whole block as the panel will hold it once the requested columns are sent, using two different
+  // CRCs to get a 32-bit hash (a single CRC-16 collides for some of the regular patterns typical of UI drawing)
+  uint16_t crc = 0xFFFF;
+  uint16_t ccitt = 0xFFFF;
+  for (uint8_t i = 0; i < SH1106_HASH_BLOCK; ++i)
+  {
+    crc = _crc16_update(crc, data[i]);
+    ccitt = _crc_ccitt_update(ccitt, data[i]);
+  }
+  const uint32_t hash = ((uint32_t)crc << 16) | ccitt;
+
+  bool changed = true;
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+  {
+    // columns of the block that are not being sent only match the buffer if they have no pending changes
+    const uint8_t dirty_start = dirty_col_start_[page];
+    const uint8_t dirty_end = dirty_col_end_[page];
+    if ((col_start != block_start || col_end != block_end)
+        && ((dirty_start < col_start && dirty_end >= block_start) || (dirty_end > col_end && dirty_start <= block_end)))
+    {
+      hash_valid_[page] &= ~bit;
+    }
+    // skip the block if the panel already holds this content
+    else if ((hash_valid_[page] & bit) && block_hash_[page][block] == hash)
+    {
+      changed = false;
+    }
+    else
+    {
+      block_hash_[page][block] = hash;
+      hash_valid_[page] |= bit;
+    }
+  }
+
+  return changed;
+}
+#endif
+
+inline bool DUINO_SH1106::clip_window(int16_t & y, int16_t & h)
+{
+  // clip a vertical span to the rows held in the buffer and make it relative to the buffer
+  if (y < window_top_)
+  {
+    h -= window_top_ - y;
+    y = window_top_;
+  }
+  if ((y + h) > window_bottom_)
+  {
+    h = window_bottom_ - y;
+  }
+  y -= window_top_;
+
+  return h > 0;
+}
+
+void DUINO_SH1106::render_window(uint8_t page)
+{
+  // move the buffer window to start at this page and redraw it
+  window_top_ = page * 8;
+  window_bottom_ = min((page + buffer_pages_) * 8, SH1106_LCDHEIGHT);
+  memset(buffer, 0, buffer_pages_ * SH1106_LCDWIDTH);
+
+  if (render_callback_)
+  {
+    rendering_ = true;
+    render_callback_();
+    rendering_ = false;
+  }
+}
+
+uint8_t DUINO_SH1106::overlay_column(const Overlay & o, uint8_t page, uint8_t col)
+{
+  // pixels of one column of an overlay on a page, combined the same way draw calls with Inverse would be
+  const int16_t top = o.y;
+  const int16_t bottom = o.y + o.height - 1;
+  const int16_t left = o.x;
+  const int16_t right = o.x + o.width - 1;
+  uint8_t mask = 0x00;
+
+  switch (o.style)
+  {
+    case OverlayFull:
+      mask = page_rows(top, bottom, page);
+      break;
+    case OverlayBox:
+      if (col == left)
+      {
+        mask ^= page_rows(top, bottom, page);
+      }
+      if (col == right)
+      {
+        mask ^= page_rows(top, bottom, page);
+      }
+      if (col > left && col < right)
+      {
+        mask ^= page_rows(top, top, page) ^ page_rows(bottom, bottom, page);
+      }
+      break;
+    case OverlayDottedBox:
+      if (!((col - left) & 1))
+      {
+        mask ^= page_rows(top, top, page) ^ page_rows(bottom, bottom, page);
+      }
+      if (col == left || col == right)
+      {
+        uint8_t dots = 0x00;
+        for (int16_t row = top + 2; row < bottom - 1; row += 2)
+        {
+          dots ^= page_rows(row, row, page);
+        }
+        if (col == left)
+        {
+          mask ^= dots;
+        }
+        if (col == right)
+        {
+          mask ^= dots;
+        }
+      }
+      break;
+    case OverlayCorners:
+      if (col == left)
+      {
+        mask ^= page_rows(top, top + 1, page) ^ page_rows(bottom - 1, bottom, page);
+      }
+      if (col == left + 1)
+      {
+        mask ^= page_rows(top, top, page) ^ page_rows(bottom, bottom, page);
+      }
+      if (col == right)
+      {
+        mask ^= page_rows(top, top + 1, page) ^ page_rows(bottom - 1, bottom, page);
+      }
+      if (col == right - 1)
+      {
+        mask ^= page_rows(top, top, page) ^ page_rows(bottom, bottom, page);
+      }
+      break;
+  }
+
+  return mask;
+}
+
+void DUINO_SH1106::mark_overlay_dirty(const Overlay & o)
+{
+  const int16_t right = o.x + o.width - 1;
+  const int16_t bottom = o.y + o.height - 1;
+  mark_dirty(o.x, right < SH1106_LCDWIDTH ? right : SH1106_LCDWIDTH - 1, o.y / 8,
+      (bottom < SH1106_LCDHEIGHT ? bottom : SH1106_LCDHEIGHT - 1) / 8);
+}
+
+inline void DUINO_SH1106::mark_dirty(uint8_t col_start, uint8_t col_end, uint8_t page_start, uint8_t page_end)
+{
+  // drawing done while rendering a window recreates content that is already being sent
+  if (rendering_)
+  {
+    return;
+  }
+
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+  {
+    for (uint8_t page = page_start; page <= page_end; ++page)
+    {
+      if (col_start < dirty_col_start_[page])
+      {
+        dirty_col_start_[page] = col_start;
+      }
+      if (col_end > dirty_col_end_[page])
+      {
+        dirty_col_end_[page] = col_end;
+      }
+    }
+  }
+}
+
+void DUINO_SH1106::mark_rect(int16_t x, int16_t y, int16_t w, int16_t h)
+{
+  // clip to the display, then mark the pages and columns covered
+  if (x < 0)
+  {
+    w += x;
+    x = 0;
+  }
+  if (y < 0)
+  {
+    h += y;
+    y = 0;
+  }
+  if ((x + w) > SH1106_LCDWIDTH)
+  {
+    w = SH1106_LCDWIDTH - x;
+  }
+  if ((y + h) > SH1106_LCDHEIGHT)
+  {
+    h = SH1106_LCDHEIGHT - y;
+  }
+  if (w > 0 && h > 0)
+  {
+    mark_dirty(x, x + w - 1, y / 8, (y + h - 1) / 8);
+  }
+}
+
+void DUINO_SH1106::mark_all_dirty()
+{
+  for (uint8_t page = 0; page < SH1106_LCDHEIGHT / 8; ++page)
+  {
+    dirty_col_start_[page] = 0;
+    dirty_col_end_[page] = SH1106_LCDWIDTH - 1;
+  }
 }
 
-DUINO_SH1106 Display(5, 4);
+DUINO_SH1106 Display;
@@ -35,6 +35,32 @@
 #define SH1106_LCDWIDTH                                  128
 #define SH1106_LCDHEIGHT                 	               64
 
+#define SH1106_PIN_SS                                      5
+#define SH1106_PIN_DC                                      4
+
+// columns sent per atomic block when flushing (power of two)
+#define SH1106_FLUSH_SLICE                                16
+
+// pages (of 128 bytes) held in the display buffer; fewer than 8 saves RAM, but requires paged mode (a render callback)
+#define SH1106_BUFFER_PAGES                                8
+
+#if SH1106_BUFFER_PAGES < 1 || SH1106_BUFFER_PAGES > (SH1106_LCDHEIGHT / 8)
+#error "SH1106_BUFFER_PAGES must be from 1 to 8"
+#endif
+
+// maximum number of inverted overlay rectangles (e.g. widget selections)
+#define SH1106_OVERLAYS                                    4
+
+// columns hashed together when skipping unchanged content (multiple of SH1106_FLUSH_SLICE, at least 16)
+#define SH1106_HASH_BLOCK                                 32
+
+// skip flushing blocks whose content the panel already holds (uses 136 bytes of RAM)
+#define SH1106_SKIP_UNCHANGED                              1
+
+#if (SH1106_LCDWIDTH / SH1106_HASH_BLOCK) > 8 || (SH1106_HASH_BLOCK % SH1106_FLUSH_SLICE)
+#error "SH1106_HASH_BLOCK must be a multiple of SH1106_FLUSH_SLICE and at least 16"
+#endif
+
 #define SH1106_SETLOWCOLUMN                             0x00
 #define SH1106_SETHIGHCOLUMN                            0x10
 #define SH1106_SETPUMPVOLTAGE                           0x30
@@ -67,7 +93,15 @@ public:
     Inverse
   };
 
-  DUINO_SH1106(uint8_t ss, uint8_t dc);
+  enum OverlayStyle
+  {
+    OverlayFull,
+    OverlayBox,
+    OverlayDottedBox,
+    OverlayCorners
+  };
+
+  DUINO_SH1106();
 
   void sh1106_command(uint8_t command);
   void sh1106_spi_write(uint8_t data);
@@ -75,6 +109,18 @@ public:
 
   void display(uint8_t col_start, uint8_t col_end, uint8_t page_start, uint8_t page_end);
   void display();
+  void flush();
+
+  void set_buffer_pages(uint8_t pages);
+  void attach_render_callback(void (*callback)());
+  bool paged() const { return buffer_pages_ < SH1106_LCDHEIGHT / 8; }
+
+  int8_t add_overlay(uint8_t x, uint8_t y, uint8_t width, uint8_t height, OverlayStyle style);
+  void remove_overlay(int8_t overlay);
+
+  void scroll(int8_t rows);
+  uint8_t scroll_row(int16_t y) const { return (y + start_line_) & (SH1106_LCDHEIGHT - 1); }
+  uint8_t get_start_line() const { return start_line_; }
 
   void clear_display();
 
@@ -92,17 +138,64 @@ public:
 
   void draw_bitmap_7(int16_t x, int16_t y, const unsigned char * map, unsigned char c, Color color);
   void draw_bitmap_8(int16_t x, int16_t y, const unsigned char * map, unsigned char c, Color color);
+  void draw_sprite(int16_t x, int16_t y, int16_t w, int16_t h, const unsigned char * map, const unsigned char * mask,
+      Color color);
 
   void draw_du_logo_lg(int16_t x, int16_t y, Color color);
   void draw_du_logo_sm(int16_t x, int16_t y, Color color);
   void draw_logick_logo(int16_t x, int16_t y, Color color);
 
 private:
+  struct Overlay
+  {
+    uint8_t x, y, width, height;
+    uint8_t style;
+  };
+
+  inline void pixel(int16_t x, int16_t y, Color color, bool mark);
+  inline void vline(int16_t x, int16_t y, int16_t h, Color color, bool mark);
   inline void draw_quadrants(int16_t xc, int16_t yc, int16_t x, int16_t y, Color color);
   inline void fill_quadrants(int16_t xc, int16_t yc, int16_t x, int16_t y, Color color);
+  inline void draw_band(int16_t x, int16_t y, int16_t w, const unsigned char * map, const unsigned char * mask,
+      uint8_t rows, Color color);
+
+  inline void compose_block(uint8_t page, uint8_t block_start, uint8_t * block);
+  inline void display_slice(uint8_t page, uint8_t col_start, uint8_t col_end, const uint8_t * data);
+
+#if SH1106_SKIP_UNCHANGED
+  bool block_changed(uint8_t page, uint8_t block_start, uint8_t col_start, uint8_t col_end, const uint8_t * data);
+#endif
+  inline bool clip_window(int16_t & y, int16_t & h);
+  void render_window(uint8_t page);
+
+  inline void mark_dirty(uint8_t col_start, uint8_t col_end, uint8_t page_start, uint8_t page_end);
+  void mark_rect(int16_t x, int16_t y, int16_t w, int16_t h);
+  void mark_all_dirty();
+
+  uint8_t overlay_column(const Overlay & o, uint8_t page, uint8_t col);
+  void mark_overlay_dirty(const Overlay & o);
+
+  // per-page column span modified since it was last sent (clean if start > end)
+  volatile uint8_t dirty_col_start_[SH1106_LCDHEIGHT / 8];
+  volatile uint8_t dirty_col_end_[SH1106_LCDHEIGHT / 8];
+
+#if SH1106_SKIP_UNCHANGED
+  // hash of each block as last sent to the panel, and which of them are known to match it
+  uint32_t block_hash_[SH1106_LCDHEIGHT / 8][SH1106_LCDWIDTH / SH1106_HASH_BLOCK];
+  uint8_t hash_valid_[SH1106_LCDHEIGHT / 8];
+#endif
+
+  // pages held in the buffer, and the display rows they currently cover (the whole display unless paged)
+  uint8_t buffer_pages_;
+  uint8_t window_top_, window_bottom_;
+
+  uint8_t start_line_;
+
+  // inverted rectangles composited over the buffer as it is sent (unused if width is zero)
+  Overlay overlays_[SH1106_OVERLAYS];
 
-  const uint8_t pin_ss_;
-  const uint8_t pin_dc_;
+  volatile bool rendering_;
+  void (*render_callback_)();
 };
 
 extern DUINO_SH1106 Display;
@@ -79,6 +79,32 @@ void DUINO_Widget::attach_scroll_callback(void (*callback)(int))
   scroll_callback_ = callback;
 }
 
+int8_t DUINO_Widget::toggle_overlay(int8_t overlay, uint8_t x, uint8_t y, uint8_t width, uint8_t height,
+    InvertStyle style)
+{
+  if (overlay == WIDGET_INVERTED_IN_BUFFER)
+  {
+    draw_invert(x, y, width, height, style);
+    return -1;
+  }
+
+  if (overlay > -1)
+  {
+    Display.remove_overlay(overlay);
+    return -1;
+  }
+
+  // with every overlay in use, invert the buffer instead, so the widget is still inverted exactly when it says it is
+  overlay = Display.add_overlay(x, y, width, height, (DUINO_SH1106::OverlayStyle)style);
+  if (overlay < 0)
+  {
+    draw_invert(x, y, width, height, style);
+    return WIDGET_INVERTED_IN_BUFFER;
+  }
+
+  return overlay;
+}
+
 void DUINO_Widget::draw_invert(uint8_t x, uint8_t y, uint8_t width, uint8_t height, InvertStyle style)
 {
   switch(style)
@@ -122,19 +148,17 @@ DUINO_DisplayWidget::DUINO_DisplayWidget(uint8_t x, uint8_t y, uint8_t width, ui
   : width_(width)
   , height_(height)
   , style_(style)
-  , inverted_(false)
+  , overlay_(-1)
   , DUINO_DisplayObject(x, y)
 {
 }
 
 void DUINO_DisplayWidget::invert(bool update_display)
 {
-  draw_invert(x(), y(), width(), height(), style_);
+  overlay_ = toggle_overlay(overlay_, x(), y(), width(), height(), style_);
 
   if (update_display)
   {
     display();
   }
-
-  inverted_ = !inverted_;
 }
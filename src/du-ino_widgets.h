@@ -26,6 +26,9 @@
 #include "Arduino.h"
 #include "du-ino_sh1106.h"
 
+// overlay handle of a widget inverted by drawing into the display buffer, when all display overlays are in use
+#define WIDGET_INVERTED_IN_BUFFER                         -2
+
 /** Display object (UI element) abstract base class. */
 class DUINO_DisplayObject
 {
@@ -54,12 +57,13 @@ public:
     Scroll
   };
 
+  // drawn as display overlays, so inverting never touches the display buffer (unless all are in use)
   enum InvertStyle
   {
-    Full,
-    Box,
-    DottedBox,
-    Corners
+    Full = DUINO_SH1106::OverlayFull,
+    Box = DUINO_SH1106::OverlayBox,
+    DottedBox = DUINO_SH1106::OverlayDottedBox,
+    Corners = DUINO_SH1106::OverlayCorners
   };
 
   DUINO_Widget();
@@ -76,6 +80,8 @@ public:
   void attach_scroll_callback(void (*callback)(int));
 
 protected:
+  static int8_t toggle_overlay(int8_t overlay, uint8_t x, uint8_t y, uint8_t width, uint8_t height,
+      InvertStyle style);
   static void draw_invert(uint8_t x, uint8_t y, uint8_t width, uint8_t height, InvertStyle style);
 
   void (*click_callback_)();
@@ -90,7 +96,7 @@ public:
   DUINO_DisplayWidget(uint8_t x, uint8_t y, uint8_t width, uint8_t height, InvertStyle style);
 
   virtual void invert(bool update_display = true);
-  virtual bool inverted() const { return inverted_; }
+  virtual bool inverted() const { return overlay_ != -1; }
 
   virtual uint8_t width() const { return width_; }
   virtual uint8_t height() const { return height_; }
@@ -98,7 +104,7 @@ public:
 protected:
   const uint8_t width_, height_;
   const InvertStyle style_;
-  bool inverted_;
+  int8_t overlay_;
 };
 
 /** N-element widget array abstract base class template. */
@@ -287,7 +293,7 @@ public:
     , step_(step)
     , vertical_(vertical)
     , style_(style)
-    , inverted_(false)
+    , overlay_(-1)
     , DUINO_WidgetArray<N>(t, initial_selection)
     , DUINO_DisplayObject(x, y)
   { }
@@ -300,17 +306,15 @@ public:
 
   virtual void invert(bool update_display = true)
   {
-    this->draw_invert(x(this->selected_), y(this->selected_), width(), height(), style_);
+    overlay_ = this->toggle_overlay(overlay_, x(this->selected_), y(this->selected_), width(), height(), style_);
 
     if (update_display)
     {
       this->display();
     }
-
-    inverted_ = !inverted_;
   }
 
-  virtual bool inverted() const { return inverted_; }
+  virtual bool inverted() const { return overlay_ != -1; }
 
   using DUINO_DisplayObject::x;
   using DUINO_DisplayObject::y;
@@ -328,7 +332,7 @@ protected:
   const uint8_t width_, height_, step_;
   const bool vertical_;
   const DUINO_Widget::InvertStyle style_;
-  bool inverted_;
+  int8_t overlay_;
 };
 
 /** Widget container (organizer of functional widget hierarchy) class template. */